@@ -0,0 +1,17 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+// Counts the heap allocations made through the global operator new (replaced in
+// AllocationCounter.cpp), per thread, so a loop can check that it stopped
+// allocating once it runs. Allocations straight from malloc (C libraries,
+// the GL driver) aren't seen.
+class AllocationCounter
+{
+public:
+	// allocations the calling thread made so far
+	static size_t thisThread();
+};
+
+#endif
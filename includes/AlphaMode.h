@@ -0,0 +1,41 @@
+#ifndef ALPHA_MODE_H
+#define ALPHA_MODE_H
+
+#include <cstddef>
+#include <string>
+
+// How a texture / material uses its alpha, decides the pipeline a mesh draws with:
+// opaque (no discard, early depth test), cutout (alpha tested) or blend.
+enum AlphaMode { ALPHA_OPAQUE = 0, ALPHA_CUTOUT = 1, ALPHA_BLEND = 2 };
+
+// Scans decoded 8 bit pixels (alpha is the last of `channels`). Texels that are
+// (almost) 0 or 255 only make a cutout, antialiased edges may leave a few in between.
+inline AlphaMode classifyAlpha(const unsigned char* pixels, int width, int height, int channels)
+{
+    if (!pixels || (channels != 2 && channels != 4)) return ALPHA_OPAQUE;
+    size_t count = (size_t)width * (size_t)height, transparent = 0, partial = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned char alpha = pixels[i * channels + channels - 1];
+        if (alpha < 248) transparent++;
+        if (alpha > 8 && alpha < 248) partial++;
+    }
+    if (transparent == 0) return ALPHA_OPAQUE;
+    return partial * 20 < count ? ALPHA_CUTOUT : ALPHA_BLEND;
+}
+
+// names used in cooked texture metadata
+inline const char* alphaModeName(int mode)
+{
+    return mode == ALPHA_BLEND ? "blend" : (mode == ALPHA_CUTOUT ? "cutout" : "opaque");
+}
+
+inline AlphaMode alphaModeFromName(const std::string& name, AlphaMode fallback)
+{
+    if (name == "opaque") return ALPHA_OPAQUE;
+    if (name == "cutout") return ALPHA_CUTOUT;
+    if (name == "blend") return ALPHA_BLEND;
+    return fallback;
+}
+
+#endif
@@ -13,7 +13,20 @@ public:
     
     //Shaders:
     MAIN = "main",
+    MAIN_CUTOUT = "mainCutout",
+    MAIN_BLEND = "mainBlend",
     SKYBOX = "skybox",
+    IMPOSTOR = "impostor",
+    IMPOSTOR_BAKE = "impostorBake",
+    GBUFFER = "gbuffer",
+    GBUFFER_CUTOUT = "gbufferCutout",
+    DEFERRED_LIGHTING = "deferredLighting",
+    SHADOW_DEPTH = "shadowDepth",
+    OIT_COMPOSITE = "oitComposite",
+    UPSCALE = "upscale",
+    FXAA = "fxaa",
+    TAA_VELOCITY = "taaVelocity",
+    TAA_RESOLVE = "taaResolve",
 
     
     //Textures
@@ -29,7 +42,13 @@ public:
 
     //Objects:
     WALL = "wall",
-    TRANSFORMER = "transformer"
+    TRANSFORMER = "transformer",
+    SPHERES = "spheres",
+
+    //Load graph (objects load under their own names):
+    RESOURCES = "resources",
+    MATERIALS = "materials",
+    IMPOSTORS = "impostors"
     ;
 };
 
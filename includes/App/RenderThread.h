@@ -0,0 +1,65 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "Renderer.h"
+#include "SpscQueue.h"
+
+// Owns the GL context and the Renderer on a thread of its own. The main thread
+// polls events, runs the simulation and hands over one FrameInput per frame
+// through a lock free queue. With one slot it prepares frame N+1 while N is
+// drawn, and submit() waits when it gets a whole frame ahead. Both sides sleep on
+// a condition variable while there is nothing for them; the render thread is
+// also woken for GL jobs, which it runs without waiting for a frame.
+class RenderThread
+{
+public:
+	static const size_t QUEUE_DEPTH = 1;
+
+	struct Settings
+	{
+		RenderPath renderPath;
+		AntiAliasing antiAliasing;
+		int swapInterval;
+		// render on demand: draw only what changed, re-present at least minRefresh times a second
+		bool onDemand;
+		double minRefresh;
+		// hidden window sharing the context, for the UploadThread (nullptr: uploads on the render thread)
+		GLFWwindow* uploadContext;
+	};
+
+	// the window's context must not be current on the calling thread
+	RenderThread(GLFWwindow* window, const Settings& settings);
+	~RenderThread();
+	// blocks while the queue is full; on demand also until the render thread has
+	// decided whether this input needs drawing, so isIdle() is about it
+	void submit(FrameInput&& input);
+	// render on demand: the last submitted frame draws nothing, the main thread may sleep
+	bool isIdle() const { return idle.load(std::memory_order_acquire); }
+	// draws what is queued, releases the context and joins (before glfwTerminate)
+	void stop();
+
+private:
+	GLFWwindow* window;
+	Settings settings;
+	SpscQueue<FrameInput, QUEUE_DEPTH> queue;
+	std::atomic<bool> stopping, idle;
+	// the queue changed, GL jobs were queued or stop() was called
+	std::mutex wakeMutex;
+	std::condition_variable frameQueued, frameTaken, frameJudged;
+	bool glWork;
+	// inputs submitted / gone through needsRender (render on demand)
+	uint64_t submitted, judged;
+	std::thread thread;
+
+	void run();
+	void notify(std::condition_variable& condition);
+};
+
+#endif
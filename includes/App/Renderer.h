@@ -6,25 +6,154 @@
 
 #include "Skybox.h"
 #include "Light.h"
-#include "Controller.h"
+#include "ClusteredLights.h"
+#include "GBuffer.h"
+#include "FullscreenTriangle.h"
+#include "CascadedShadows.h"
+#include "WeightedOIT.h"
+#include "DynamicResolution.h"
+#include "PostAntiAliasing.h"
+#include "DrawLists.h"
+#include "FrameAllocator.h"
+#include "camera.h"
+
+#include <array>
+
+// chosen once at startup
+enum class RenderPath { Forward, Deferred };
+
+// immutable per frame state from the main thread (RenderThread::submit)
+struct FrameInput
+{
+    // interpolated between the last two simulation ticks
+    Camera camera;
+    bool isNight = false;
+    // real time since the last frame (sky transition)
+    float deltaTime = 0.0f;
+    int framebufferWidth = 0, framebufferHeight = 0;
+    bool windowChanged = false;
+    // instance matrices the simulation changed, by model name
+    map<string, vector<glm::mat4>> instanceUpdates;
+    // the point lights, if the simulation changed them
+    bool pointLightsChanged = false;
+    vector<PointLight> pointLights;
+};
+
+// what the last drawn frame showed, for render on demand
+struct FrameSnapshot
+{
+    glm::vec3 cameraPosition, cameraFront, cameraUp;
+    float cameraZoom;
+    unsigned int lightVersion, instanceVersion;
+    bool isNight;
+
+    bool operator==(const FrameSnapshot& other) const;
+};
 
 class Renderer : public Scene
 {
 private:
-    Skybox skybox;     // skybox.setEnvironment(false); // evening
+    RenderPath renderPath;
+    GBuffer gBuffer;
+    FullscreenTriangle fullscreenTriangle;
+    Skybox skybox;
+    // sky blend, 0 = morning, 1 = night, eased toward controller.isNight
+    float nightAmount = 0.0f;
+    // seconds a full morning/night transition takes
+    const float SKY_TRANSITION_TIME = 2.0f;
     Light light;
+    ClusteredLights lightClusters;
+    CascadedShadows shadows;
+    WeightedOIT transparency;
+    // offscreen scene target, its resolution follows the GPU frame time
+    DynamicResolution resolution;
+    // size the scene is drawn at this frame (resolution.renderWidth/Height)
+    glm::vec2 renderSize;
+    // anti-aliasing pass between the scene and the upscale
+    PostAntiAliasing antiAliasing;
     map<string, TextureManager> textures;
     map<string, Shader> shaders;
 
     const unsigned int SCR_WIDTH = 800;
     const unsigned int SCR_HEIGHT = 600;
+    const float Z_NEAR = 0.1f;
+    const float Z_FAR = 100.0f;
+    // GPU time per frame dynamic resolution aims for (ms), with room for the CPU and swap
+    const float GPU_FRAME_BUDGET = 14.0f;
+    // sharpening of the upscale at the lowest scale, it fades out toward full resolution
+    const float UPSCALE_SHARPNESS = 1.0f;
+    // samples of the scene target with AntiAliasing::MSAA
+    const int MSAA_SAMPLES = 4;
+    // share of the history in every TAA frame (higher: smoother, but slower to follow changes)
+    const float TAA_FEEDBACK = 0.9f;
+
+    // render on demand: state of the last frame, frames still drawn after the last change
+    // (TAA converges, the resolution scale follows the timings) and the texture presented
+    FrameSnapshot lastFrame;
+    int settleFrames = 0;
+    GLuint lastSceneTexture = 0;
+    const int SETTLE_FRAMES = 4;
+    const int TAA_SETTLE_FRAMES = 32;
+    // view distance covered by the shadow cascades
+    const float SHADOW_DISTANCE = 100.0f;
+
+    // texture storage the streamed mip levels may take
+    const size_t TEXTURE_MEMORY_BUDGET = (size_t)384 << 20;
+
+    // transient data of the frame being drawn (draw lists, LOD selection, light clusters)
+    FrameAllocator frameMemory;
+    // per frame culling, LOD selection and sorting of the instances, as jobs
+    DrawListBuilder drawLists;
+    // debug builds assert that a frame (render thread and draw list jobs) allocates nothing
+    // once nothing loads, streams or changes size; the frames before STEADY_WARMUP in a row
+    // still size the buffers (main.cpp checks the main thread's part)
+    int steadyFrames = 0;
+    const int STEADY_WARMUP = 2;
+
+    // upper bound of triangles drawn for one LOD mesh per frame
+    const unsigned int LOD_TRIANGLE_BUDGET = 2000000;
+    // the LOD bias doubles up to this many times until the budget holds
+    static const int LOD_BIAS_STEPS = 8;
+
+    // distance where 3D models cross-fade from mesh to impostor
+    const glm::vec2 IMPOSTOR_FADE = glm::vec2(30.0f, 40.0f);
+    // per frame split of a model's instances, reused between frames and sized for all of them
+    // (meshInstances: the first solidInstanceCount are not fading)
+    vector<glm::mat4> meshInstances, impostorInstances;
+    GLsizei solidInstanceCount = 0;
 
 
 public:
-    Renderer();
-    void render(Controller& controller);
-    void draw(string ObjectName, int numOfVertices);
-    void draw3Dmodel(string modelName);
+    // uploads (optional): a shared context for the big uploads, outliving the renderer
+    Renderer(RenderPath renderPath = RenderPath::Forward, AntiAliasing antiAliasingMode = AntiAliasing::FXAA, UploadThread* uploads = nullptr);
+    // takes over the instance and light changes of a frame, before needsRender/render
+    void applyInput(const FrameInput& input);
+    void render(const FrameInput& input);
+    // render on demand: false while the last frame still shows the scene as it is
+    // (camera, lights, instances, sky and streamed textures unchanged, nothing settling)
+    bool needsRender(const FrameInput& input);
+    // upscales the last frame to the window again, without drawing the scene
+    void presentLast(const FrameInput& input);
+    // draws the meshes whose material alpha mode is in alphaModes (bit 1 << AlphaMode) with the shader in use
+    void draw3Dmodel(const string& modelName, GLsizei firstInstance, GLsizei instanceCount, unsigned int alphaModes);
+    bool hasTranslucent(const string& modelName);
+    // per frame uniforms of a material pipeline, lit: forward shading uniforms too
+    void setupMaterialShader(Shader& shader, const glm::mat4& projection, const glm::mat4& view, glm::vec3 viewPos, bool lit);
+    void renderShadows(const Camera& camera);
+    void drawShadowCasters(bool dynamic);
+    // culls the instances and sorts them front to back into meshInstances/impostorInstances
+    void splitImpostorInstances(const string& modelName, glm::vec3 viewPos, const glm::mat4& view, const Frustum& frustum);
+    // asks TextureArrays for the mip detail of the nearest mesh instance (meshInstances)
+    void requestTextureDetail(const string& modelName, glm::vec3 viewPos, float pixelsPerUnit);
+    // picks the levels of a LOD mesh's instances, appending their matrices and draws to the frame's lists
+    void addLodDraws(const string& objectName, const glm::mat4& view, const Frustum& frustum, float pixelsPerUnit,
+                     FrameVector<glm::mat4>& instanceData, FrameVector<PrimitiveRegistry::Draw>& draws);
+    // runs the FXAA or TAA pass on the resolved scene, returns the texture to upscale
+    // (viewProjection without the jitter, jitteredViewProjection the one the scene was drawn with)
+    GLuint antiAlias(const glm::mat4& viewProjection, const glm::mat4& jitteredViewProjection);
+    // upscales sceneTexture (laid out like the scene target) to the window
+    // (anything drawn afterwards is at native resolution)
+    void present(const GLint windowViewport[4], GLuint sceneTexture);
 
 };
 #endif
@@ -17,9 +17,11 @@ public:
     map<string, Shader> shaders;
     map<string, TextureManager> textures;
 
-    ResourceManager();
-    void setShaders();
-    void setTextures();
+    // materialDefines: extra lines for the shaders that sample model materials,
+    // streamer: loads the textures in the background when given
+    ResourceManager(const string& materialDefines = "", TextureStreamer* streamer = nullptr);
+    void setShaders(const string& materialDefines);
+    void setTextures(TextureStreamer* streamer);
 };
 
 #endif
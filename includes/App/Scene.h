@@ -6,6 +6,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <vector>
+#include <set>
 
 #include "App.h"
 
@@ -19,34 +20,103 @@
 #include "Cylinder.h"
 #include "Cone.h"
 #include "Torus.h"
+#include "LodMesh.h"
+#include "PrimitiveRegistry.h"
 
 #include "Model.h"
+#include "TextureStreamer.h"
+#include "TextureArrays.h"
+#include "MaterialTable.h"
+#include "Impostor.h"
+#include "LoadGraph.h"
 
 
 using namespace std;
 
+// position only copy of a mesh for depth passes (shares the mesh's index buffer)
+struct ShadowCaster
+{
+    unsigned int VAO, positionVBO;
+    GLsizei indexCount;
+};
+
 class Scene : public App
 {
 public:
-    map<string, VAO> vaos;
-    map<string, EBO> ebos;
-    map<string, Sphere> spheres;
-    map<string, Icosphere> icos;
-    map<string, Cubesphere> cubes;
-    map<string, Cylinder> cylinders;
-    map<string, Cone> cones;
-    map<string, Torus> toruses;
+    // every procedural primitive (single shapes and LOD levels) in one set of buffers
+    PrimitiveRegistry primitives;
+    // registry handles of the single shapes, their instances are models[name]
+    map<string, int> primitiveHandles;
+    map<string, LodMesh> lodMeshes;
 
     map<string, vector<glm::mat4>> models;
 
     map<string, Model> threeDModels;
+    // decodes and uploads every texture in the background
+    TextureStreamer textureStreamer;
+    // material textures and materials of all models
+    TextureArrays textureArrays;
+    MaterialTable materials;
+    map<string, unsigned int> instanceBuffers;
+    // first instance the mesh VAOs of a model currently read
+    map<string, GLsizei> instanceOffsets;
+    map<string, Impostor> impostors;
+    // bounding radius of every mesh of a 3D model, for the texture detail requests
+    map<string, vector<float>> meshRadii;
+    // bounding sphere of a whole 3D model (model space center, radius in w), for culling
+    map<string, glm::vec4> modelBounds;
+
+    //shadow casters, all instances of a model (static ones unless listed in dynamicModels):
+    map<string, vector<ShadowCaster>> shadowCasters;
+    map<string, unsigned int> shadowInstanceBuffers;
+    set<string> dynamicModels;
+    // bump when static casters change so the cached shadow cascades are re-rendered
+    unsigned int staticVersion;
+    // bump when instance matrices change (dynamicModels count as changing every frame)
+    unsigned int instanceVersion;
+    // until the textures queued at load time are all resident
+    bool initialStreaming;
+    // the objects load here side by side, their GL stages come in between frames
+    // (last member: it is gone first and skips what hasn't started)
+    LoadGraph loading;
 
 
     
-    Scene();
+    // uploads (optional): fills the big buffers and textures on a context of its own
+    Scene(UploadThread* uploads = nullptr);
+
+    // once per frame: streams the texture detail asked for, uploads streamed textures
+    // and refreshes the materials they change; true once, in the frame the first
+    // load of every texture is complete
+    bool updateStreaming();
+    // model materials from their (resolved) textures into the MaterialTable
+    void resolveMaterials();
 
-    void cubeBuffers(string name);
     void threeDmodelBuffers(string name);
+    // new matrices for the instances of a 3D model or LOD mesh (at most as many as it
+    // was loaded with, the GPU buffers are sized then)
+    void setInstances(string name, const vector<glm::mat4>& matrices);
+    // base instance for GL 3.3: re-points the instance matrix of every mesh of a model
+    void setInstanceOffset(const string& name, GLsizei firstInstance);
+    void impostorBuffers(string name, Shader& bakeShader);
+    void shadowBuffers(string name);
+    // uploads a Sphere, Icosphere, Cubesphere, Cylinder, Cone or Torus into the registry
+    template<class Shape>
+    void primitiveBuffers(const string& name, const Shape& shape)
+    {
+        primitiveHandles[name] = primitives.add(shape);
+        primitives.upload();
+        instanceVersion++;
+    }
+    // uploads the resolution levels of a primitive (e.g. Sphere::buildLods(...)),
+    // the renderer then picks a level per instance of models[name]
+    template<class Shape>
+    void lodBuffers(string name, const vector<Shape>& levels)
+    {
+        lodMeshes[name] = LodMesh(levels, primitives);
+        primitives.upload();
+        instanceVersion++;
+    }
     
 };
 
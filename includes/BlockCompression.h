@@ -0,0 +1,23 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <cstdint>
+#include <vector>
+
+// CPU encoders of the BCn formats the texture cooker writes. The block functions
+// take 4x4 RGBA8 texels (16 * 4 bytes, row by row).
+
+// BC1 (8 bytes): principal axis endpoints, refined by least squares, 4 colour mode only
+void encodeBC1(const unsigned char* rgba, unsigned char* block);
+// BC4 (8 bytes) of one channel (0 = red ... 3 = alpha)
+void encodeBC4(const unsigned char* rgba, int channel, unsigned char* block);
+// BC3 (16 bytes): BC4 alpha + BC1 colour
+void encodeBC3(const unsigned char* rgba, unsigned char* block);
+// BC5 (16 bytes): BC4 red + BC4 green (normal maps)
+void encodeBC5(const unsigned char* rgba, unsigned char* block);
+
+// whole RGBA8 image into blocks of a KTX2Format (BC1, BC3, BC4 or BC5), the rows of
+// blocks are split over threads; edge blocks repeat the last row / column
+std::vector<unsigned char> compressImage(const unsigned char* rgba, int width, int height, uint32_t vkFormat, int threads = 1);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef CASCADED_SHADOWS_H
+#define CASCADED_SHADOWS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "camera.h"
+
+// Cascaded shadow maps of the directional light. Static and dynamic casters go to
+// separate depth arrays: a static cascade is cached and only re-rendered when the
+// light or the static geometry changes, or when the camera leaves the cascade's
+// guard band; the dynamic cascades are rendered every frame. Cascades are fitted to
+// bounding spheres of the frustum slices and snapped to texels to avoid shimmering.
+class CascadedShadows
+{
+public:
+	static const int CASCADES = 4;
+	static const int RESOLUTION = 2048;
+	// texture units of the static / dynamic shadow arrays
+	static const int STATIC_UNIT = 7, DYNAMIC_UNIT = 8;
+
+	glm::mat4 staticLightSpace[CASCADES], dynamicLightSpace[CASCADES];
+	// view space distance where every cascade ends
+	float splits[CASCADES];
+
+	CascadedShadows();
+	// fits the cascades for this frame, returns the static cascades that must be re-rendered (bit 1 << cascade)
+	unsigned int update(const Camera& camera, float aspect, float zNear, float shadowDistance, glm::vec3 lightDirection, unsigned int staticVersion);
+	// binds the framebuffer to a cleared layer of the static / dynamic array
+	void beginStatic(int cascade);
+	void beginDynamic(int cascade);
+	// back to sceneFBO and its viewport
+	void end(const GLint viewport[4], GLuint sceneFBO = 0);
+	// binds the arrays and sets the cascade uniforms of a lighting shader
+	void bind(Shader& shader);
+	void Delete();
+
+private:
+	GLuint FBO, staticMap, dynamicMap;
+	glm::vec3 cachedLightDirection;
+	unsigned int cachedStaticVersion;
+	bool cacheValid;
+	// light space sphere the static cascade was rendered for
+	glm::vec3 staticCenter[CASCADES];
+	float staticRadius[CASCADES], staticFitRadius[CASCADES];
+
+	void beginLayer(GLuint map, int cascade);
+};
+
+#endif
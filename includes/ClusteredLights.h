@@ -0,0 +1,46 @@
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "shader.h"
+#include "Light.h"
+#include "FrameAllocator.h"
+
+// Bins point lights into a view space froxel grid (GRID_X x GRID_Y screen tiles,
+// GRID_Z exponential depth slices) once per frame on the CPU. The fragment
+// shader reads its cluster's [offset, count] range and shades only those lights.
+// Buffers are texture buffers so the GL 3.3 core context is enough.
+class ClusteredLights
+{
+public:
+    static const int GRID_X = 16, GRID_Y = 9, GRID_Z = 24;
+    // texture units of the light data, cluster range and light index buffers
+    static const int LIGHT_UNIT = 4, RANGE_UNIT = 5, INDEX_UNIT = 6;
+
+    ClusteredLights();
+    // rebuilds the cluster lists for this frame's camera, the scratch data in frameMemory (nullptr: the heap)
+    void update(const std::vector<PointLight>& lights, const glm::mat4& view, float fovY, float aspect, float zNear, float zFar,
+                FrameAllocator* frameMemory = nullptr);
+    // binds the buffers and sets the cluster uniforms of a shader
+    void bind(Shader& shader, glm::vec2 screenSize);
+    void Delete();
+
+private:
+    struct Bounds { int x0, x1, y0, y1, z0, z1; };
+
+    GLuint lightBuffer, rangeBuffer, indexBuffer;
+    GLuint lightTexture, rangeTexture, indexTexture;
+    GLsizeiptr lightCapacity, indexCapacity;
+    float zNear, zFar;
+
+    // CPU side copy of the cluster ranges, reused between frames
+    std::vector<GLuint> ranges;
+
+    int slice(float depth) const;
+    void upload(GLuint buffer, GLsizeiptr& capacity, const void* data, GLsizeiptr size);
+};
+
+#endif
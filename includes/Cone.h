@@ -35,9 +35,14 @@ public:
          int stackCount=1, bool smooth=true, int up=3);
     ~Cone() {}
 
+    // pre-built resolution levels for LOD selection, finest first
+    static std::vector<Cone> buildLods(float baseRadius, float height, int sectorCount,
+                                       int stackCount, int levelCount=4, bool smooth=true, int up=3);
+
     // getters/setters
     float getBaseRadius() const             { return baseRadius; }
     float getHeight() const                 { return height; }
+    float getBoundingRadius() const;
     int getSectorCount() const              { return sectorCount; }
     int getStackCount() const               { return stackCount; }
     void set(float baseRadius, float height, int sectorCount,  int stackCount,
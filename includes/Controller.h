@@ -23,18 +23,27 @@ private:
     float lastX, lastY;
     bool firstMouse;
 
+    // Fixed tick simulation: camera position before the last tick, for interpolation
+    glm::vec3 previousPosition;
+    float interpolation;
+    // N toggles on the press, not every frame it is held
+    bool nightKeyDown;
+
     // Settings
     const unsigned int SCR_WIDTH;
     const unsigned int SCR_HEIGHT;
 
     // Private utility functions
     static void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+    static void window_refresh_callback(GLFWwindow* window);
     static void mouse_callback(GLFWwindow* window, double xpos, double ypos);
     static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
 public:
     //morning/night
     bool isNight;
+    //the window was resized or needs its contents again (render on demand)
+    bool windowChanged;
 
     // Constructor
     Controller(unsigned int width = 800, unsigned int height = 600);
@@ -44,12 +53,22 @@ public:
 
     // Window initialization
     bool initializeWindow(const std::string& title);
+    // hidden window whose context shares objects with the window's (nullptr if there is none)
+    GLFWwindow* createUploadContext();
 
     //Get Camera
     Camera& getCamera() { return camera; }
+    // camera as the renderer sees it: the position is interpolated between the last two ticks
+    Camera getRenderCamera() const;
 
-    // Input handling
+    // Input handling, once per frame: window and toggle keys (the mouse looks around in its callback)
     void processInput();
+    // one fixed simulation step: moves the camera by the held keys
+    void tick(float seconds);
+    // a movement key is held: the next ticks change the camera (render on demand must not idle)
+    bool isMoving() const;
+    // share of a tick since the last one (FrameScheduler::alpha)
+    void setInterpolation(float alpha) { interpolation = alpha; }
 
     // Main loop management
     GLFWwindow* getWindow() const { return window; }
@@ -57,6 +76,9 @@ public:
 
     // Timing utilities
     void updateDeltaTime();
+    float getDeltaTime() const { return deltaTime; }
+    // after the loop slept: the next delta starts now instead of covering the sleep
+    void resetDeltaTime() { lastFrame = static_cast<float>(glfwGetTime()); }
     void initializeOpenGLSettings();
 };
 
@@ -25,8 +25,12 @@ public:
     Cubesphere(float radius=1.0f, int subdivision=3, bool smooth=true);
     ~Cubesphere() {}
 
+    // pre-built resolution levels for LOD selection, finest first
+    static std::vector<Cubesphere> buildLods(float radius, int subdivision, int levelCount=4, bool smooth=true);
+
     // getters/setters
     float getRadius() const                 { return radius; }
+    float getBoundingRadius() const         { return radius; }
     void setRadius(float radius);
     float getSideLength() const             { return radius * 2 / sqrt(3.0f); }
     void setSideLength(float side);
@@ -37,10 +37,15 @@ public:
              int sectorCount=36, int stackCount=1, bool smooth=true, int up=3);
     ~Cylinder() {}
 
+    // pre-built resolution levels for LOD selection, finest first
+    static std::vector<Cylinder> buildLods(float baseRadius, float topRadius, float height,
+                                           int sectorCount, int stackCount, int levelCount=4, bool smooth=true, int up=3);
+
     // getters/setters
     float getBaseRadius() const             { return baseRadius; }
     float getTopRadius() const              { return topRadius; }
     float getHeight() const                 { return height; }
+    float getBoundingRadius() const;
     int getSectorCount() const              { return sectorCount; }
     int getStackCount() const               { return stackCount; }
     void set(float baseRadius, float topRadius, float height,
@@ -0,0 +1,69 @@
+#ifndef DRAW_LISTS_H
+#define DRAW_LISTS_H
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstdint>
+
+#include "FrameAllocator.h"
+#include "FunctionRef.h"
+#include "JobSystem.h"
+
+// view frustum planes (Gribb & Hartmann), normals point inside
+struct Frustum
+{
+	glm::vec4 planes[6];
+
+	Frustum() {}
+	explicit Frustum(const glm::mat4& viewProjection);
+	bool intersectsSphere(glm::vec3 center, float radius) const;
+};
+
+// one instance in a draw list; ties in the key keep the instance order
+struct DrawItem
+{
+	uint32_t key;
+	uint32_t instance;
+
+	bool operator<(const DrawItem& other) const
+	{
+		return key != other.key ? key < other.key : instance < other.instance;
+	}
+};
+
+// Per frame draw lists built in parallel over instance ranges. Every job culls
+// its range, emits (sort key, instance) pairs into a buffer of its own and sorts
+// it; the sorted buffers are then merged on the calling thread, so the GL
+// submission after it sees one ordered list. All of it lives in the frame
+// allocator, a build makes no heap allocations. Keys hold a bucket (pipeline, LOD
+// level...) in the high 8 bits and the view depth in the low 24, so every bucket
+// comes out front to back.
+class DrawListBuilder
+{
+public:
+	// instances per job
+	static const size_t GRAIN = 2048;
+
+	// jobs (nullptr: all on the calling thread), frameMemory (nullptr: the heap) holds the lists
+	explicit DrawListBuilder(JobSystem* jobSystem = nullptr, FrameAllocator* frameMemory = nullptr);
+	static uint32_t sortKey(unsigned int bucket, float depth, float maxDepth);
+	static unsigned int bucket(const DrawItem& item) { return item.key >> 24; }
+
+	// emit(begin, end, job, items): adds the visible instances of [begin, end) to items,
+	// job (begin / GRAIN) indexes per job results. The list stays valid until the next build
+	// or the frame memory's reset.
+	const FrameVector<DrawItem>& build(size_t count, FunctionRef<void(size_t, size_t, size_t, FrameVector<DrawItem>&)> emit);
+	// runs body over ranges of a finished list (e.g. compacting the instance matrices)
+	void forEachRange(size_t count, FunctionRef<void(size_t, size_t)> body);
+	size_t jobCount(size_t count) const { return (count + GRAIN - 1) / GRAIN; }
+	// heap allocations the ranges made (on whichever thread ran them) since the last call
+	size_t takeJobAllocations() { return jobAllocations.exchange(0, std::memory_order_relaxed); }
+
+private:
+	JobSystem* jobSystem;
+	FrameAllocator* frameMemory;
+	FrameVector<DrawItem> merged;
+	std::atomic<size_t> jobAllocations;
+};
+
+#endif
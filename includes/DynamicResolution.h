@@ -0,0 +1,59 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Offscreen scene target whose resolution follows the GPU frame time.
+// The GPU time between begin() and end() is measured with GL_TIME_ELAPSED
+// queries, read a few frames later so reading them never stalls. From it, the
+// scale of the next frames is picked so the time holds the target. The target is
+// allocated once at full size and only the bottom left renderWidth() x
+// renderHeight() is drawn, so a new scale costs no reallocation. The renderer then
+// upscales that part to the window (upscale.fs); whatever is drawn after it is at
+// native resolution.
+// With samples > 1 the scene is drawn multisampled into renderbuffers and end()
+// resolves it into the single sampled textures the post passes read.
+class DynamicResolution
+{
+public:
+	static const int QUERY_LATENCY = 4;
+	static constexpr float MIN_SCALE = 0.5f;
+
+	// what the scene is drawn into, resolveFBO unless multisampled
+	GLuint FBO;
+	// single sampled RGBA8 color (linear filtered for the upscale) and depth/stencil
+	// (same format as the default framebuffer's, so the OIT pass can blit it)
+	GLuint resolveFBO, color, depth;
+	// multisampled attachments of FBO (0 without MSAA)
+	GLuint msaaColorRBO, msaaDepthRBO;
+	unsigned int width, height;
+	int samples;
+	// side length of the rendered part relative to the target
+	float scale;
+
+	DynamicResolution();
+	DynamicResolution(unsigned int width, unsigned int height, float targetMilliseconds, int samples = 1);
+	// binds the target with the viewport of the current scale and starts timing
+	void begin();
+	// resolves the samples (if any) and stops timing, finished measurements adjust the scale
+	void end();
+	unsigned int renderWidth() const;
+	unsigned int renderHeight() const;
+	// texture coordinates of the rendered part's far corner
+	glm::vec2 uvScale() const;
+	// smoothed GPU time of a frame
+	float gpuMilliseconds() const { return filteredTime; }
+	void bindTexture(GLuint unit);
+	void Delete();
+
+private:
+	GLuint queries[QUERY_LATENCY];
+	bool issued[QUERY_LATENCY];
+	int nextQuery;
+	float targetTime, filteredTime;
+
+	void adjust(float milliseconds);
+};
+
+#endif
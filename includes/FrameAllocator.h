@@ -0,0 +1,84 @@
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for data that only lives for one frame (draw lists, culling
+// results, light clusters). allocate() takes the next bytes of one block, from
+// any thread, nothing is freed on its own; reset() at the start of the next frame
+// hands the whole block out again. A frame that needs more than the block holds
+// gets the rest from the heap, and the next reset() grows the block to fit, so
+// the frames after it stay inside.
+class FrameAllocator
+{
+public:
+	static constexpr size_t DEFAULT_CAPACITY = (size_t)1 << 20;
+	// alignment of the block, allocations may not ask for more
+	static constexpr size_t BLOCK_ALIGNMENT = 64;
+
+	explicit FrameAllocator(size_t capacity = DEFAULT_CAPACITY);
+	~FrameAllocator();
+	FrameAllocator(const FrameAllocator&) = delete;
+	FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	// frees the whole frame; no job may still use its memory
+	void reset();
+	size_t capacity() const { return size; }
+	// the heap helped out since the last reset()
+	bool overflowed() const { return overflowBytes.load(std::memory_order_relaxed) > 0; }
+
+private:
+	unsigned char* block;
+	size_t size;
+	std::atomic<size_t> offset, overflowBytes;
+	std::mutex overflowMutex;
+	std::vector<void*> overflow;
+
+	static unsigned char* allocateBlock(size_t size);
+};
+
+// std allocator drawing from a FrameAllocator; deallocate() is a no-op there.
+// Without one it falls back to the heap, so the same containers work outside a frame.
+template<class T>
+class FrameStlAllocator
+{
+public:
+	using value_type = T;
+	// the memory goes with the allocator it came from
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	FrameAllocator* frame;
+
+	FrameStlAllocator(FrameAllocator* frame = nullptr) noexcept : frame(frame) {}
+	template<class U>
+	FrameStlAllocator(const FrameStlAllocator<U>& other) noexcept : frame(other.frame) {}
+
+	T* allocate(size_t count)
+	{
+		if (!frame) return std::allocator<T>().allocate(count);
+		return (T*)frame->allocate(count * sizeof(T), alignof(T));
+	}
+	void deallocate(T* pointer, size_t count) noexcept
+	{
+		if (!frame) std::allocator<T>().deallocate(pointer, count);
+	}
+};
+
+template<class T, class U>
+bool operator==(const FrameStlAllocator<T>& a, const FrameStlAllocator<U>& b) { return a.frame == b.frame; }
+template<class T, class U>
+bool operator!=(const FrameStlAllocator<T>& a, const FrameStlAllocator<U>& b) { return a.frame != b.frame; }
+
+// valid until the FrameAllocator's next reset()
+template<class T>
+using FrameVector = std::vector<T, FrameStlAllocator<T>>;
+
+#endif
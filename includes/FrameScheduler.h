@@ -0,0 +1,40 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <chrono>
+
+// Main loop timing: the simulation runs at a fixed tick, the renderer at whatever
+// rate the GPU and swap interval allow. Every frame, the elapsed real time is
+// turned into a whole number of ticks, and the remainder is returned by alpha()
+// so the renderer can interpolate between the last two ticks. After a long stall,
+// at most MAX_TICKS_PER_FRAME ticks are run; the rest of the time is dropped
+// rather than caught up with (that would only make the next frame longer).
+// With a frame rate cap, waitForDeadline() sleeps until the frame's slot; it
+// sleeps coarsely and then yields for the last stretch, since sleep_for
+// oversleeps by up to a scheduler quantum.
+class FrameScheduler
+{
+public:
+	static const int MAX_TICKS_PER_FRAME = 8;
+
+	// maxFrameRate 0: no cap (vsync or the GPU set the pace)
+	FrameScheduler(double tickRate = 60.0, double maxFrameRate = 0.0);
+	// adds the time since the last frame, returns how many ticks to run now
+	int beginFrame();
+	double tickSeconds() const { return tick; }
+	// how far the frame is between the last tick and the next (0..1)
+	float alpha() const;
+	// frame pacing: sleeps until this frame's deadline when a cap is set
+	void waitForDeadline();
+	// forgets the time since the last frame (after the loop slept on purpose); the
+	// frame after it still runs one tick, so the input that ended the sleep is applied
+	void reset();
+
+private:
+	using Clock = std::chrono::steady_clock;
+	double tick, frameInterval;
+	double accumulator;
+	Clock::time_point lastTime, deadline;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef FULLSCREEN_TRIANGLE_H
+#define FULLSCREEN_TRIANGLE_H
+
+#include <glad/glad.h>
+
+// One triangle covering the whole viewport, the vertices are generated from
+// gl_VertexID in fullscreen.vs so the VAO has no buffers at all.
+class FullscreenTriangle
+{
+public:
+	GLuint VAO;
+	FullscreenTriangle();
+	void draw();
+	void Delete();
+};
+
+#endif
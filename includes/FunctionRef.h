@@ -0,0 +1,34 @@
+#ifndef FUNCTION_REF_H
+#define FUNCTION_REF_H
+
+#include <type_traits>
+#include <utility>
+
+template<class Signature>
+class FunctionRef;
+
+// Non-owning reference to something callable, for callbacks that are only called
+// before the function taking them returns (parallelFor, draw list builds). Unlike
+// std::function it never copies the callable, so passing a lambda with a large
+// capture costs no allocation; the callable has to outlive the reference.
+template<class R, class... Args>
+class FunctionRef<R(Args...)>
+{
+public:
+	template<class F, class = std::enable_if_t<!std::is_same<std::decay_t<F>, FunctionRef>::value>>
+	FunctionRef(F&& callable) : object((void*)&callable), call(&invoke<std::remove_reference_t<F>>) {}
+
+	R operator()(Args... args) const { return call(object, std::forward<Args>(args)...); }
+
+private:
+	void* object;
+	R (*call)(void*, Args...);
+
+	template<class F>
+	static R invoke(void* object, Args... args)
+	{
+		return (*(F*)object)(std::forward<Args>(args)...);
+	}
+};
+
+#endif
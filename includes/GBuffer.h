@@ -0,0 +1,28 @@
+#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <glad/glad.h>
+
+// Geometry buffer of the deferred path:
+// 0: albedo.rgb + specular intensity (RGBA8)
+// 1: octahedral encoded world normal + specular exponent (RGB16F)
+// depth: the position is reconstructed from it in the lighting pass
+class GBuffer
+{
+public:
+	GLuint FBO;
+	GLuint albedoSpec, normal, depth;
+	unsigned int width, height;
+
+	GBuffer();
+	GBuffer(unsigned int width, unsigned int height);
+	// binds the framebuffer for the geometry pass, drawing the bottom left viewWidth x viewHeight
+	void Bind(unsigned int viewWidth, unsigned int viewHeight);
+	// back to the framebuffer the lighting pass draws into
+	void Unbind(GLuint sceneFBO = 0);
+	// binds the attachments to texture units firstUnit, +1, +2 for the lighting pass
+	void bindTextures(GLuint firstUnit);
+	void Delete();
+};
+
+#endif
@@ -24,8 +24,12 @@ public:
     Icosphere(float radius=1.0f, int subdivision=2, bool smooth=false);
     ~Icosphere() {}
 
+    // pre-built resolution levels for LOD selection, finest first
+    static std::vector<Icosphere> buildLods(float radius, int subdivision, int levelCount=4, bool smooth=false);
+
     // getters/setters
     float getRadius() const                 { return radius; }
+    float getBoundingRadius() const         { return radius; }
     void setRadius(float radius);
     int getSubdivision() const              { return subdivision; }
     void setSubdivision(int subdivision);
@@ -0,0 +1,36 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Model.h"
+#include "shader.h"
+
+// Octahedral impostor of a Model: the model is rendered once at load time from
+// framesPerSide x framesPerSide view directions into an atlas (color + normal/depth),
+// far instances are then drawn as camera facing quads sampling the nearest views.
+class Impostor {
+private:
+    unsigned int quadVAO, quadVBO, instanceVBO;
+    int maxInstances;
+    void bake(Model& model, Shader& bakeShader);
+
+public:
+    unsigned int colorAtlas, normalDepthAtlas;
+    int framesPerSide, frameResolution;
+    // bounding sphere of the model (model space)
+    glm::vec3 center;
+    float radius;
+
+    Impostor();
+    Impostor(Model& model, Shader& bakeShader, int maxInstances, int framesPerSide = 8, int frameResolution = 128);
+    // renders the atlas again, e.g. once the model's streamed textures are resident
+    void rebake(Model& model, Shader& bakeShader);
+    // draws one quad per instance matrix, fade = (start, end) distance of the LOD cross-fade
+    void draw(Shader& shader, const std::vector<glm::mat4>& instances, const glm::vec2& fade);
+    void Delete();
+};
+
+#endif
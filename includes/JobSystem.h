@@ -0,0 +1,149 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FunctionRef.h"
+
+// Frame: per frame work someone waits for, Background: loading, decoding...
+// wait() only helps with Frame jobs, so a frame never ends up decoding a texture.
+enum class JobPriority { Frame = 0, Background = 1 };
+
+struct Job;
+
+// Counts unfinished jobs: run() adds one, the job's end takes it off again.
+// Jobs given to runAfter() start when it next drops to zero.
+class JobCounter
+{
+public:
+	JobCounter() : pending(0) {}
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+	bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<int> pending;
+	// the drop to zero and the continuations
+	std::mutex mutex;
+	std::vector<Job*> continuations;
+};
+
+// Engine wide job system: one worker per core but the one the render thread
+// keeps (one at least), each with a work stealing deque (Chase & Lev) per priority. A worker
+// pushes and pops at the bottom of its own deques, idle ones steal from the top
+// of the others'; other threads hand jobs in through a shared FIFO. Workers with
+// nothing to do sleep until a job is queued. GL calls only work on the thread
+// with the context, so jobs can queue work for it with runOnGLThread(), which
+// that thread runs in runGLJobs() (setGLWake() tells it there is some).
+// Finished jobs are kept for reuse and parallelFor() takes its body by
+// reference, so a frame's jobs don't allocate.
+class JobSystem
+{
+public:
+	// jobs a worker deque holds, more go to the shared queue
+	static const int DEQUE_CAPACITY = 4096;
+	// jobs made up front: how many are in flight at once varies with the timing, a
+	// pool that only grew on demand could still allocate frames after the first
+	static const int INITIAL_JOBS = 1024;
+
+	// threads: at least one, Background jobs only run on workers
+	explicit JobSystem(unsigned int threads = std::max(2u, std::thread::hardware_concurrency()) - 1);
+	// finishes the queued jobs, then joins the workers
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	// the process wide instance, created on first use
+	static JobSystem& shared();
+
+	unsigned int workerCount() const { return (unsigned int)workers.size(); }
+	// counter (optional) stays above zero until work has run
+	void run(std::function<void()> work, JobCounter* counter = nullptr, JobPriority priority = JobPriority::Frame);
+	// work starts once dependency drops to zero (right away if it is)
+	void runAfter(JobCounter& dependency, std::function<void()> work, JobCounter* counter = nullptr,
+	              JobPriority priority = JobPriority::Frame);
+	// work done outside the job system (another thread, the GPU) keeps counter up until release()
+	void hold(JobCounter& counter);
+	void release(JobCounter& counter);
+	// returns when counter is zero, running Frame jobs (and, on the GL thread, GL jobs) meanwhile
+	void wait(JobCounter& counter);
+	// body(begin, end) for the chunks [k * grain, (k + 1) * grain) of [0, count), returns when all ran;
+	// allocates nothing, so it fits in a frame
+	void parallelFor(size_t count, size_t grain, FunctionRef<void(size_t begin, size_t end)> body,
+	                 JobPriority priority = JobPriority::Frame);
+
+	// the calling thread holds the GL context from now on
+	void setGLThread();
+	// called (from any thread) whenever GL work is queued, so a sleeping GL thread picks it up
+	void setGLWake(std::function<void()> wake);
+	void runOnGLThread(std::function<void()> work, JobCounter* counter = nullptr);
+	// GL thread: runs what was queued for it
+	void runGLJobs();
+
+private:
+	class WorkDeque
+	{
+	public:
+		WorkDeque();
+		// owner only
+		bool push(Job* job);
+		Job* pop();
+		// any thread
+		Job* steal();
+
+	private:
+		std::atomic<int64_t> top, bottom;
+		std::unique_ptr<std::atomic<Job*>[]> slots;
+	};
+	struct Worker
+	{
+		WorkDeque deques[2];
+		std::thread thread;
+	};
+	// FIFO linked through the jobs, so queueing never allocates
+	struct JobQueue
+	{
+		Job* head = nullptr;
+		Job* tail = nullptr;
+
+		void push(Job* job);
+		Job* pop();
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	// jobs from threads that aren't workers, per priority
+	JobQueue injected[2];
+	std::mutex injectedMutex;
+	// finished jobs for reuse
+	JobQueue freeJobs;
+	std::mutex freeMutex;
+	// queued anywhere, for the sleeping workers
+	std::atomic<int> queued, sleeping;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	bool stopping;
+
+	std::vector<Job*> glJobs;
+	std::mutex glMutex;
+	std::thread::id glThread;
+	std::function<void()> glWake;
+
+	Job* createJob(JobCounter* counter, JobPriority priority);
+	void schedule(Job* job);
+	// highest priority first, down to lowest
+	Job* find(int worker, JobPriority lowest);
+	void execute(Job* job);
+	void finish(JobCounter* counter);
+	void work(int worker);
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef KTX2_H
+#define KTX2_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "AlphaMode.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+// VkFormat values of the block compressed formats the cooker writes / the loader knows
+enum KTX2Format : uint32_t
+{
+    KTX2_BC1_RGB = 131,
+    KTX2_BC1_RGBA = 133,
+    KTX2_BC3 = 137,
+    KTX2_BC4 = 139,
+    KTX2_BC5 = 141,
+    KTX2_BC7 = 145
+};
+
+// Single 2D texture in a KTX 2.0 file: block compressed, every mip level, no
+// supercompression. Key/value metadata is kept as strings (KTXorientation,
+// KTXwriter and the cooker's alphaMode).
+struct KTX2Texture
+{
+    uint32_t vkFormat = 0;
+    int width = 0, height = 0;
+    // level 0 first
+    std::vector<std::vector<unsigned char>> levels;
+    // number of levels in the file (levels stays empty after a header only read)
+    int levelCount = 0;
+    std::map<std::string, std::string> metadata;
+
+    // headerOnly: size, format and metadata without the level data
+    bool read(const std::string& path, bool headerOnly = false);
+    bool write(const std::string& path) const;
+
+    // GL internal format of vkFormat, 0 if unknown
+    GLenum glFormat() const;
+    // alpha class the cooker stored, without one a guess from the format
+    AlphaMode alphaMode() const;
+    // bytes of one 4x4 block, 0 for unknown formats
+    static int blockBytes(uint32_t vkFormat);
+    static int glBlockBytes(GLenum glFormat);
+    static size_t levelBytes(uint32_t vkFormat, int width, int height);
+
+    // the cooked file of an image: same name with the .ktx2 extension
+    static std::string cookedPath(const std::string& source);
+    // reads the cooked file of source if there is one that is not older than source,
+    // was cooked with the same vertical flip and has a full mip chain
+    static bool findCooked(const std::string& source, bool flip, KTX2Texture& texture, bool headerOnly = false);
+};
+
+#endif
@@ -15,33 +15,43 @@
 #include <vector>
 
 
+struct PointLight {
+    glm::vec3 position, color, ambient, diffuse, specular;
+    float constant, linear, quadratic;
+    // distance where the attenuated light drops below 1/256, used for clustering
+    float radius;
+};
 
 class Light
 {
 public:
     // directional light:
     glm::vec3 dirLightColor, dirLightDirection, dirLightAmbient, dirLightDiffuse, dirLightSpecular;
-    // Point light:
-    glm::vec3 pointLightColor[6], pointLightAmbient[6], pointLightDiffuse[6], pointLightSpecular[6], pointLightPosition[6];
-    float pointLightConstant[6], pointLightLinear[6], pointLightQuadratic[6];
+    // Point light (any number, binned into clusters by the renderer every frame):
+    std::vector<PointLight> pointLights;
     // Spot light:
     glm::vec3 spotLightColor, spotLightPosition, spotLightDirection, spotLightAmbient, spotLightDiffuse, spotLightSpecular;
     float spotLightConstant, spotLightLinear, spotLightQuadratic, spotLightCutOff,spotLightOuterCutOff;
     
     //for turning Lights on and off
     bool enableDir, enableSpot;
-    int numOfPoints;
-    //shader
-    Shader myShader;
+    //shaders that light (every pipeline variant has its own uniforms)
+    std::vector<Shader> myShaders;
     //comera position:
     glm::vec3 viewPos;
+    //bumped by turnOnDir/turnOnPoint, bump it after changing the fields directly
+    //(the spot light follows the camera, that change is the camera's)
+    unsigned int version;
     //Material:
     
     Light(Shader shader, bool enableDir, int numOfPoints, bool enableSpot);
     Light();
+    // also keeps the uniforms of another shader up to date
+    void addShader(Shader shader);
 
     void turnOnDir();
     void turnOnPoint();
+    int addPointLight(glm::vec3 position, glm::vec3 color = glm::vec3(1.0f));
     void turnOnSpot();
     void update(glm::vec3 cameraPos, glm::vec3 cameraFront);
 	
@@ -0,0 +1,62 @@
+#ifndef LOAD_GRAPH_H
+#define LOAD_GRAPH_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "UploadThread.h"
+
+// Start-up loading as a graph of named assets. Every asset has a CPU stage (file
+// reads, decoding, imports, geometry) that runs as a background job, an upload
+// stage (filling big buffers and textures) for the UploadThread if there is one,
+// and a GL stage (VAOs, shader compiles, anything else that needs the render
+// context) that is then queued for the GL thread; without an upload thread the
+// upload stage runs right before it. An asset starts once the assets it depends
+// on are done, the rest load side by side. The GL stages run whenever the GL thread calls
+// JobSystem::runGLJobs() or waits here, so the first frame only waits for what it
+// can't do without and the other assets come in over the next frames.
+class LoadGraph
+{
+public:
+	explicit LoadGraph(JobSystem& jobs = JobSystem::shared());
+	// before the first add()
+	void setUploadThread(UploadThread* uploads) { this->uploads = uploads; }
+	// GL thread: skips the stages not started yet, waits for the running ones
+	~LoadGraph();
+	LoadGraph(const LoadGraph&) = delete;
+	LoadGraph& operator=(const LoadGraph&) = delete;
+
+	// cpu, upload, gl: any may be empty; dependencies are added before
+	void add(const std::string& name, std::function<void()> cpu, std::function<void()> upload, std::function<void()> gl,
+	         const std::vector<std::string>& dependencies = {});
+	void add(const std::string& name, std::function<void()> cpu, std::function<void()> gl,
+	         const std::vector<std::string>& dependencies = {})
+	{
+		add(name, std::move(cpu), nullptr, std::move(gl), dependencies);
+	}
+	bool done(const std::string& name) const;
+	bool allDone() const;
+	// GL thread: returns once name is done, running GL stages meanwhile
+	void wait(const std::string& name);
+	void waitAll();
+
+private:
+	struct Node
+	{
+		std::function<void()> cpu, upload, gl;
+		// dependencies not done, the CPU stage, the whole asset
+		JobCounter dependencies, cpuDone, done;
+	};
+
+	JobSystem& jobs;
+	UploadThread* uploads;
+	std::map<std::string, std::unique_ptr<Node>> nodes;
+	std::atomic<bool> cancelled;
+};
+
+#endif
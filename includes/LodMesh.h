@@ -0,0 +1,52 @@
+#ifndef LOD_MESH_CLASS_H
+#define LOD_MESH_CLASS_H
+
+#include<glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include"PrimitiveRegistry.h"
+
+// A procedural primitive at several resolutions (see buildLods() of Sphere,
+// Icosphere, Cubesphere, Cylinder, Cone and Torus), finest level first. The
+// levels live in a PrimitiveRegistry, so all LOD meshes draw together.
+class LodMesh
+{
+public:
+	struct Level
+	{
+		// handle in the registry
+		int primitive;
+		GLsizei indexCount;
+	};
+	std::vector<Level> levels;
+	// radius of the sphere containing the primitive (model space)
+	float boundingRadius;
+	// smallest projected radius (pixels) a level is used for, finest first
+	std::vector<float> minScreenRadius;
+
+	LodMesh();
+	// Adds every level to primitives (uploaded with its next upload())
+	template<class Shape>
+	LodMesh(const std::vector<Shape>& shapes, PrimitiveRegistry& primitives);
+
+	// Picks the level for a projected radius, bias > 1 prefers coarser levels
+	int selectLevel(float screenRadius, float bias) const;
+	unsigned int getTriangleCount(int level) const { return (unsigned int)levels[level].indexCount / 3; }
+
+private:
+	void setScreenRadii();
+};
+
+template<class Shape>
+LodMesh::LodMesh(const std::vector<Shape>& shapes, PrimitiveRegistry& primitives) : boundingRadius(0.0f)
+{
+	for (const Shape& shape : shapes)
+	{
+		levels.push_back({ primitives.add(shape), (GLsizei)shape.getIndexCount() });
+		boundingRadius = glm::max(boundingRadius, shape.getBoundingRadius());
+	}
+	setScreenRadii();
+}
+
+#endif
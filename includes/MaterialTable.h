@@ -0,0 +1,40 @@
+#ifndef MATERIAL_TABLE_H
+#define MATERIAL_TABLE_H
+
+#include <glad/glad.h>
+#include <vector>
+
+#include "shader.h"
+#include "mesh.h"
+
+// Deduplicated materials of every loaded model in one texture buffer (RGBA32UI,
+// TEXELS_PER_MATERIAL texels each: texture slots, then shininess / alpha mode /
+// tiling). Meshes only pass their index as a constant
+// vertex attribute, so switching material needs no uniform or texture update.
+// Entry 0 is the default material of primitives drawn with bound textures.
+class MaterialTable
+{
+public:
+    static const int TEXELS_PER_MATERIAL = 2;
+    // texture unit of the table
+    static const int UNIT = 13;
+
+    MaterialTable();
+    // index of an equal entry, appended if there is none
+    int add(const Material& material);
+    const Material& get(int index) const { return materials[index]; }
+    int size() const { return (int)materials.size(); }
+    // drops every entry but the default one (indices handed out before are invalid)
+    void clear() { materials.resize(1); }
+    // copies the table to the GPU, call after adding
+    void upload();
+    // binds the table and sets the "materials" sampler of a shader
+    void bind(Shader& shader) const;
+    void Delete();
+
+private:
+    std::vector<Material> materials;
+    GLuint buffer, texture;
+};
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef MIP_CHAIN_H
+#define MIP_CHAIN_H
+
+#include <algorithm>
+#include <vector>
+
+// Next mip level of 8 bit pixels: 2x2 box filter, the last row / column is
+// repeated for odd sizes. width and height become the size of the result.
+inline void halveImage(const std::vector<unsigned char>& pixels, int& width, int& height, int channels, std::vector<unsigned char>& result)
+{
+    int halfWidth = std::max(1, width / 2), halfHeight = std::max(1, height / 2);
+    result.resize((size_t)halfWidth * halfHeight * channels);
+    for (int y = 0; y < halfHeight; y++) {
+        const unsigned char* row0 = &pixels[(size_t)std::min(2 * y, height - 1) * width * channels];
+        const unsigned char* row1 = &pixels[(size_t)std::min(2 * y + 1, height - 1) * width * channels];
+        for (int x = 0; x < halfWidth; x++) {
+            int x0 = std::min(2 * x, width - 1) * channels, x1 = std::min(2 * x + 1, width - 1) * channels;
+            for (int c = 0; c < channels; c++)
+                result[((size_t)y * halfWidth + x) * channels + c] =
+                    (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+        }
+    }
+    width = halfWidth;
+    height = halfHeight;
+}
+
+#endif
@@ -16,7 +16,13 @@
 #include <map>
 #include <vector>
 
-unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false);
+class TextureArrays;
+class TextureStreamer;
+
+// alphaMode (optional) receives the classification of the decoded image; with a
+// streamer the texture starts as a placeholder and alphaMode comes from the header.
+// The texture comes from TextureCache, an image loaded before is not loaded again.
+unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false, int *alphaMode = nullptr, TextureStreamer* streamer = nullptr);
 
 class Model 
 {
@@ -27,11 +33,25 @@ public:
     bool gammaCorrection;
 
     Model();
-    Model(const std::string &path, bool gamma = false);
-    void Draw(Shader &shader);
+    // import() and upload() in one go
+    Model(const std::string &path, bool gamma = false, TextureArrays* textureArrays = nullptr, TextureStreamer* streamer = nullptr);
+    // any thread: reads the file and builds the mesh data, no GL calls
+    bool import(const std::string &path);
+    // any context sharing objects with the GL thread's (e.g. an UploadThread): the vertex
+    // and index buffers of an imported model, upload() makes the rest
+    void uploadBuffers();
+    // GL thread: mesh buffers and textures of an imported model. With textureArrays the
+    // material images are only queued, call resolveTextures() after TextureArrays::build();
+    // otherwise they go through streamer if there is one
+    void upload(TextureArrays* textureArrays = nullptr, TextureStreamer* streamer = nullptr);
+    // every mesh with the shader in use
+    void Draw();
+    void resolveTextures(const TextureArrays& textureArrays);
 
 private:
-    void loadModel(const std::string &path);
+    // textures_loaded index of every material path
+    std::map<std::string, size_t> loadedIndex;
+
     void processNode(aiNode *node, const aiScene *scene);
     Mesh processMesh(aiMesh *mesh, const aiScene *scene);
     std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
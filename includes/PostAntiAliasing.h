@@ -0,0 +1,62 @@
+#ifndef POST_ANTI_ALIASING_H
+#define POST_ANTI_ALIASING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// chosen once at startup; MSAA multisamples the scene target itself (DynamicResolution)
+enum class AntiAliasing { None, FXAA, TAA, MSAA };
+
+// Targets of the anti-aliasing pass that runs on the single sampled scene before
+// the upscale, all at render resolution (the bottom left part of full size targets,
+// like DynamicResolution's).
+// FXAA: one fullscreen pass from the scene color into output.
+// TAA: the projection is jittered by a sub-pixel Halton offset every frame. A
+// velocity pass reprojects the scene depth with the last frame's view projection
+// (camera motion; moving objects would write theirs over it), then the resolve
+// blends the frame into the reprojected history, clamped to the frame's own
+// neighbourhood so stale history doesn't ghost. The two history targets swap
+// every frame, the one just written is the output.
+class PostAntiAliasing
+{
+public:
+	// length of the jitter sequence
+	static const int JITTER_PHASES = 8;
+
+	AntiAliasing mode;
+	// FXAA result (RGBA8)
+	GLuint outputFBO, output;
+	// TAA: motion since the last frame in texture coordinates of the view (RG16F)
+	GLuint velocityFBO, velocity;
+	// TAA: accumulated color (RGBA8), [current] is written this frame
+	GLuint historyFBO[2], history[2];
+	int current;
+	unsigned int width, height;
+
+	PostAntiAliasing();
+	PostAntiAliasing(unsigned int width, unsigned int height, AntiAliasing mode);
+	// sub-pixel offset of this frame in pixels (zero unless TAA)
+	glm::vec2 jitter() const;
+	// projection shifted by jitter() for a view of renderSize pixels
+	glm::mat4 jitterProjection(const glm::mat4& projection, glm::vec2 renderSize) const;
+	// binds a target with the render viewport
+	void bindOutput(GLuint FBO, glm::vec2 renderSize);
+	// view projection (without jitter) and texture scale the history was drawn with,
+	// valid: false on the first frame, the resolve then takes the frame as it is
+	const glm::mat4& previousViewProjection() const { return lastViewProjection; }
+	glm::vec2 previousUvScale() const { return lastUvScale; }
+	bool historyValid() const { return hasHistory; }
+	// the texture to upscale this frame
+	GLuint result() const;
+	// remembers this frame for the next one and moves on in the jitter sequence
+	void endFrame(const glm::mat4& viewProjection, glm::vec2 uvScale);
+	void Delete();
+
+private:
+	glm::mat4 lastViewProjection;
+	glm::vec2 lastUvScale;
+	bool hasHistory;
+	unsigned int frame;
+};
+
+#endif
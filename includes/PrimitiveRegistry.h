@@ -0,0 +1,78 @@
+#ifndef PRIMITIVE_REGISTRY_H
+#define PRIMITIVE_REGISTRY_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// Geometry of the procedural primitives (Sphere, Icosphere, Cubesphere, Cylinder,
+// Cone, Torus) in one vertex and one index buffer. add() appends a shape's
+// interleaved vertices (position, normal, uv) and indices and returns a handle,
+// upload() moves what was added to the GPU. A single VAO reads all shapes and one
+// instance buffer the caller fills per frame, so a list of draws of any shapes
+// needs no rebinding: one glDrawElementsInstancedBaseVertex per draw, with the
+// instance attributes moved to its matrices (GL 3.3 has no base instance).
+class PrimitiveRegistry
+{
+public:
+	// what a handle stands for
+	struct Primitive
+	{
+		GLsizei indexCount;
+		// where it starts in the shared buffers
+		GLuint firstIndex;
+		GLint baseVertex;
+		float boundingRadius;
+	};
+	// instanceCount instances of a primitive, their matrices from firstInstance on
+	struct Draw
+	{
+		int primitive;
+		GLuint firstInstance;
+		GLsizei instanceCount;
+	};
+
+	PrimitiveRegistry();
+	// CPU side only, the shape may go right after
+	template<class Shape>
+	int add(const Shape& shape)
+	{
+		return add(shape.getInterleavedVertices(), shape.getInterleavedVertexCount(), shape.getIndices(),
+		           shape.getIndexCount(), shape.getBoundingRadius());
+	}
+	int add(const float* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount,
+	        float boundingRadius);
+	const Primitive& get(int handle) const { return primitives[handle]; }
+	size_t size() const { return primitives.size(); }
+
+	// GL thread: uploads what was added since the last call, the buffers grow as needed
+	void upload();
+	// GL thread: instance matrices [first, first + count) for the next draws
+	void setInstances(GLuint first, const glm::mat4* matrices, GLsizei count);
+	// GL thread: submits a list of draws
+	void draw(const Draw* draws, size_t count);
+	void Delete();
+
+private:
+	// floats per interleaved vertex
+	static const int VERTEX_FLOATS = 8;
+
+	std::vector<Primitive> primitives;
+	// added, not uploaded yet
+	std::vector<float> pendingVertices;
+	std::vector<unsigned int> pendingIndices;
+	GLuint vertexCount, indexCount;
+	GLuint VAO, vertexBuffer, indexBuffer, instanceBuffer;
+	GLsizeiptr vertexCapacity, indexCapacity, instanceCapacity;
+	// instance the matrix attributes start at
+	GLuint pointedInstance;
+
+	// room for size bytes in buffer, the first keep bytes stay
+	static void grow(GLuint& buffer, GLsizeiptr& capacity, GLsizeiptr size, GLsizeiptr keep, GLenum usage);
+	// points the VAO at the (new) buffers
+	void linkAttributes();
+	void pointInstances(GLuint first);
+};
+
+#endif
@@ -6,18 +6,31 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include "shader.h"
+#include "FullscreenTriangle.h"
+#include "TextureStreamer.h"
 
+// Drawn as one fullscreen triangle on the far plane, the fragment shader rebuilds
+// the view ray from the inverse view-projection. Both cubemaps are compressed with
+// a full mip chain; the compressed levels are cached next to the faces so later
+// runs skip the JPEG decode. Morning and night cross-fade in the shader.
+// With a TextureStreamer the maps start as grey placeholders and the decode (or
+// cache read) happens on its workers.
 class Skybox {
 private:
-    unsigned int VAO, VBO;
+    FullscreenTriangle triangle;
     unsigned int cubemapTextureMorning, cubemapTextureEvening;
-    unsigned int currentTexture;
-    unsigned int loadCubemap(const std::vector<std::string>& faces);
+    // 0 = morning, 1 = night
+    float night;
+    // through TextureCache, createCubemap() when the faces are not loaded yet
+    unsigned int loadCubemap(const std::vector<std::string>& faces, const std::string& cachePath, TextureStreamer* streamer);
+    unsigned int createCubemap(const std::vector<std::string>& faces, const std::string& cachePath, TextureStreamer* streamer);
 
 public:
-    Skybox();
+    Skybox(TextureStreamer* streamer = nullptr);
     ~Skybox();
     void draw(Shader shader, const glm::mat4& view, const glm::mat4& projection);
+    // blend between the maps, 0 = morning, 1 = night
+    void setNight(float amount);
     void setEnvironment(bool isMorning);
 };
 
@@ -24,8 +24,12 @@ public:
     Sphere(float radius=1.0f, int sectorCount=36, int stackCount=18, bool smooth=true, int up=3);
     ~Sphere() {}
 
+    // pre-built resolution levels for LOD selection, finest first
+    static std::vector<Sphere> buildLods(float radius, int sectorCount, int stackCount, int levelCount=4, bool smooth=true, int up=3);
+
     // getters/setters
     float getRadius() const                 { return radius; }
+    float getBoundingRadius() const         { return radius; }
     int getSectorCount() const              { return sectorCount; }
     int getStackCount() const               { return stackCount; }
     int getUpAxis() const                   { return upAxis; }
@@ -0,0 +1,54 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded single producer, single consumer queue without locks. The producer only
+// writes writeIndex and the consumer only readIndex; each reads the other's index
+// with acquire, so a slot is fully written before it is seen and fully read
+// before it is reused. The indices only grow, slot = index % Capacity.
+template<class T, size_t Capacity>
+class SpscQueue
+{
+public:
+	// producer: false when full (value is left untouched)
+	bool tryPush(T&& value)
+	{
+		size_t write = writeIndex.load(std::memory_order_relaxed);
+		if (write - readIndex.load(std::memory_order_acquire) == Capacity) return false;
+		slots[write % Capacity] = std::move(value);
+		writeIndex.store(write + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer: false when empty
+	bool tryPop(T& value)
+	{
+		size_t read = readIndex.load(std::memory_order_relaxed);
+		if (read == writeIndex.load(std::memory_order_acquire)) return false;
+		value = std::move(slots[read % Capacity]);
+		readIndex.store(read + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool empty() const
+	{
+		return readIndex.load(std::memory_order_acquire) == writeIndex.load(std::memory_order_acquire);
+	}
+
+	bool full() const
+	{
+		return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire) == Capacity;
+	}
+
+private:
+	std::array<T, Capacity> slots;
+	// own cache lines, so the two threads don't invalidate each other's
+	alignas(64) std::atomic<size_t> readIndex{ 0 };
+	alignas(64) std::atomic<size_t> writeIndex{ 0 };
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef TEXTURE_ARRAYS_H
+#define TEXTURE_ARRAYS_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+#include "shader.h"
+#include "mesh.h"
+#include "TextureStreamer.h"
+
+// Packs model material textures into GL_TEXTURE_2D_ARRAYs at load time.
+// Images are decoded as RGBA8 and grouped by size, each size class becomes one
+// array bound once for the whole frame. A mesh then only needs its (array, layer)
+// pairs, passed as a constant vertex attribute, to draw without texture binds.
+// Size classes beyond MAX_ARRAYS are kept as plain 2D textures the mesh binds
+// like before (GL 3.3 has no bindless textures).
+// With a TextureStreamer only the image headers are read at load time: build()
+// allocates the storage cleared to grey and the layers are filled as the streamer
+// delivers them. The alpha modes are known only then, see takeAlphaChanges().
+// Images with a cooked KTX2 file (see KTX2Texture::findCooked) keep their block
+// format: size classes are per (size, format) and those layers take the blocks as
+// they are, their alpha mode comes with the file header.
+// Mip levels stream on demand: build() loads only the levels of at most
+// RESIDENT_SIZE texels. The renderer asks for finer ones with requestDetail() from
+// the screen size of what it draws; updateResidency() loads them in the background
+// and, over the memory budget, frees the levels the least recently used textures
+// no longer need. Residency is per array (every layer gets the same levels), GL
+// 3.3 has no sparse textures, so a level is freed by re-specifying it empty.
+class TextureArrays
+{
+public:
+    static const int MAX_ARRAYS = 4;
+    // texture units of the arrays (FIRST_UNIT .. FIRST_UNIT + MAX_ARRAYS - 1)
+    static const int FIRST_UNIT = 9;
+    // largest level size loaded up front
+    static const int RESIDENT_SIZE = 128;
+    static const size_t DEFAULT_MEMORY_BUDGET = (size_t)512 << 20;
+
+    GLuint arrays[MAX_ARRAYS];
+    int arrayCount;
+
+    TextureArrays();
+    // queues an image, only its header is read here (same path is only loaded once)
+    void add(const std::string& path);
+    // creates the arrays (and leftover textures) and decodes the images into them,
+    // on the streamer's workers when there is one
+    void build(TextureStreamer* streamer = nullptr);
+    // true once after a streamed image turned out not to be opaque, the materials
+    // then have to be resolved again
+    bool takeAlphaChanges();
+    // fills slot, layer, id and alpha mode of a texture queued as directory + '/' + texture.path
+    void resolve(Texture& texture, const std::string& directory) const;
+    // a resolved texture is drawn this frame across about screenPixels pixels
+    void requestDetail(const Texture& texture, float screenPixels);
+    // once per frame: streams in the detail requested last frame, evicts over the budget
+    void updateResidency(TextureStreamer* streamer);
+    // bytes of texture storage the streamed levels may take (the coarse ones always stay)
+    void setMemoryBudget(size_t bytes) { memoryBudget = bytes; }
+    size_t memoryUsage() const { return memoryUsed; }
+    // binds the arrays and sets the textureArray0..N samplers of a shader
+    void bind(Shader& shader) const;
+    void Delete();
+
+private:
+    struct Image
+    {
+        std::string path;
+        int width, height;
+        // GL_RGBA8, or the compressed format of the cooked file
+        GLenum format;
+        int slot, layer;
+        int alphaMode;
+        GLuint id;
+    };
+    // one texture whose mip levels stream together: an array or a leftover 2D texture
+    struct Residency
+    {
+        GLuint texture;
+        GLenum target, format;
+        int width, height, levels;
+        // image of every layer
+        std::vector<size_t> images;
+        // finest level that is always there, finest level the sampler uses
+        int coarseLevel = 0, residentLevel = 0;
+        // level being loaded and the layers still missing it
+        int loadingLevel = 0, layersPending = 0;
+        // finest level asked for since the last update, and in the frame before
+        int requestedLevel = 0, neededLevel = 0;
+        unsigned int lastUse = 0;
+    };
+    std::vector<Image> images;
+    std::vector<GLuint> leftovers;
+    bool alphaChanged;
+    // arrays first (residency[slot - 1]), then the leftovers
+    std::vector<Residency> residency;
+    size_t memoryBudget, memoryUsed;
+    unsigned int frame;
+
+    static int levelCount(int width, int height);
+    // first level with at most RESIDENT_SIZE texels along both sides
+    static int coarseLevel(int width, int height);
+    // allocates the mip levels from firstLevel on of an array / 2D texture and fills them with grey
+    static void allocate(GLenum target, GLuint texture, int width, int height, int layers, GLenum format, int firstLevel = 0);
+    // storage of the levels from firstLevel on, every layer
+    static size_t residentBytes(const Residency& unit, int firstLevel);
+    // decodes levels [firstLevel, residentLevel) of every layer, the sampler moves on once all are in
+    void loadLevels(size_t unitIndex, int firstLevel, TextureStreamer* streamer);
+    void onLevelsResident(size_t unitIndex, size_t imageIndex, const StreamedImage& decoded);
+    // evicts unneeded levels of other units until bytes more fit the budget
+    bool makeRoom(size_t bytes, size_t keep);
+    // the image is resident (or decoded when loading without a streamer)
+    void onDecoded(size_t index, const StreamedImage& decoded);
+};
+
+#endif
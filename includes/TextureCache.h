@@ -0,0 +1,42 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "AlphaMode.h"
+
+class TextureStreamer;
+
+// Process wide cache of GL textures, shared by TextureManager, Model and Skybox.
+// A texture is found again by the canonical paths of its files or, for a copy of
+// the same image under another name, by the hash of their contents. Hashing reads
+// the whole files, so it only happens when a cached texture has files of the same
+// sizes (both are hashed then, the cached one only once); the variant
+// string tells apart decodes of the same files that give different textures
+// (target, channels, flip). Every acquire takes a reference, the texture is
+// deleted with the last release. GL thread only.
+class TextureCache
+{
+public:
+    // load: creates the texture (and sets alphaMode) when there is no cached one.
+    // created (optional): true when load ran, the caller sets up the sampler state then
+    static GLuint acquire(const std::vector<std::string>& files, const std::string& variant,
+                          const std::function<GLuint(int& alphaMode)>& load, int* alphaMode = nullptr, bool* created = nullptr);
+    // 2D image file as TextureManager and Model load it, through streamer if given
+    static GLuint acquire2D(const std::string& path, int channels, bool flip, TextureStreamer* streamer,
+                            int* alphaMode = nullptr, bool* created = nullptr);
+    // one more reference to a cached texture
+    static void retain(GLuint texture);
+    // deletes the texture with its last reference (textures the cache doesn't know right away)
+    static void release(GLuint texture);
+    static int references(GLuint texture);
+
+    // FNV-1a of the file contents, 0 if a file can't be read
+    static uint64_t contentHash(const std::vector<std::string>& files);
+};
+
+#endif
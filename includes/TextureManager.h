@@ -5,6 +5,9 @@
 #include<stb_image.h>
 
 #include"shader.h"
+#include"mesh.h"
+#include"TextureStreamer.h"
+#include"TextureCache.h"
 
 class TextureManager
 {
@@ -12,7 +15,11 @@ public:
 	GLuint ID;
 	GLenum type;
     GLenum texSlot;
-	TextureManager(const char* image, GLenum texType, GLenum slot, GLenum format, GLenum pixelType);
+	// classified when the image is decoded (from the header only when streamed)
+	AlphaMode alphaMode;
+	// with a streamer the texture is a placeholder until the image is resident;
+	// the texture is shared through TextureCache, Delete() drops this reference
+	TextureManager(const char* image, GLenum texType, GLenum slot, GLenum format, GLenum pixelType, TextureStreamer* streamer = nullptr);
 	TextureManager();
 	// Assigns a texture unit to a texture
 	void texUnit(Shader& shader, const char* uniform, GLuint unit);
@@ -22,7 +29,7 @@ public:
 	void Unbind();
 	// Deletes a texture
 	void Delete();
-	//enable material:
-	static void enable(Shader mainShader, TextureManager diffuseTex, TextureManager specularTex, float textureCnt);
+	//enable material: binds the textures and selects a MaterialTable entry (tiling, shininess):
+	static void enable(TextureManager diffuseTex, TextureManager specularTex, int material);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+
+#include "AlphaMode.h"
+#include "JobSystem.h"
+#include "UploadThread.h"
+
+// Decoded pixels of one texture, every mip level (and cube face) back to back.
+struct StreamedImage
+{
+    struct Level
+    {
+        // GL_TEXTURE_2D or a GL_TEXTURE_CUBE_MAP_* face
+        GLenum target;
+        int level, width, height;
+        size_t offset, size;
+    };
+    std::vector<unsigned char> data;
+    std::vector<Level> levels;
+    // pixel format of data, internalFormat is what the texture gets
+    GLenum format = GL_RGBA;
+    GLenum internalFormat = GL_RGBA8;
+    // data already holds internalFormat blocks (glCompressedTexImage2D)
+    bool compressed = false;
+    int alphaMode = ALPHA_OPAQUE;
+
+    // the cooked KTX2 version of an image file if there is a usable one (see
+    // KTX2Texture::findCooked), else the decoded image (channels 0: as stored) with its mip chain
+    bool loadFile(const std::string& path, int channels, bool flip);
+    // only the cooked blocks, uploaded as they are
+    bool loadCooked(const std::string& path, bool flip);
+    // only the decoded source image
+    bool loadSource(const std::string& path, int channels, bool flip);
+    // appends pixels and their box filtered mips as the levels of target
+    void addMips(const unsigned char* pixels, int width, int height, int channels, GLenum target);
+    size_t byteSize() const { return data.size(); }
+    // drops the mip levels outside [first, end), the data of the rest is packed again
+    void keepLevels(int first, int end);
+};
+
+// Where a StreamedImage goes.
+struct StreamDestination
+{
+    GLuint texture;
+    // GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY or GL_TEXTURE_CUBE_MAP
+    GLenum target;
+    // array layer (GL_TEXTURE_2D_ARRAY only)
+    int layer = 0;
+    // storage already allocated (arrays, bindless textures): only the contents are replaced
+    bool allocated = false;
+};
+
+// Loads textures without stalling the render thread. Decoding (and mip generation)
+// runs as background jobs of the shared JobSystem. With an UploadThread the images
+// then go straight into their textures on its context; otherwise update(), called
+// once per frame, copies them through a ring of pixel unpack buffers, at most
+// FRAME_BUDGET bytes per frame. Every requested texture exists right away
+// (load2D() gives a 1x1 placeholder) and keeps its name once the real image is in.
+class TextureStreamer
+{
+public:
+    static const int RING_SIZE = 4;
+    // bytes uploaded per frame, one image is always let through so big ones still progress
+    static const size_t FRAME_BUDGET = 8 << 20;
+
+    TextureStreamer();
+    // waits for the decodes that already started and the uploads, the rest are dropped
+    ~TextureStreamer();
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // uploads from now on go through uploads (nullptr: update() again)
+    void setUploadThread(UploadThread* uploads) { this->uploads = uploads; }
+    // decode runs as a job, the upload and onResident on the render thread in update()
+    // (or with an upload thread, on it and in JobSystem::runGLJobs())
+    void request(const StreamDestination& destination, std::function<bool(StreamedImage&)> decode,
+                 std::function<void(const StreamedImage&)> onResident = nullptr);
+    // placeholder texture streamed from an image file (channels 0: as stored)
+    GLuint load2D(const std::string& path, int channels = 0, bool flip = true,
+                  std::function<void(const StreamedImage&)> onResident = nullptr);
+    // uploads what the budget allows, call once per frame on the render thread
+    void update();
+    // requests not resident yet
+    int pending() const;
+    // deletes the unpack buffers (the decodes are stopped by the destructor)
+    void Delete();
+
+    // 1x1 mid grey texture of target (GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP)
+    static GLuint createPlaceholder(GLenum target);
+    // copies every level of image into destination, from image.data or (fromUnpackBuffer)
+    // from the bound unpack buffer holding a copy of it at offset 0
+    static void upload(const StreamDestination& destination, const StreamedImage& image, bool fromUnpackBuffer = false);
+    // alpha class known without decoding: the cooked one, else from the image
+    // header: opaque without an alpha channel, cutout otherwise
+    static AlphaMode headerAlphaMode(const std::string& path);
+    // compressed formats the driver takes (queried once, the constructor does it on the GL thread)
+    static const std::vector<GLint>& compressedFormats();
+    static bool compressedFormatSupported(GLenum format);
+
+private:
+    struct Job
+    {
+        StreamDestination destination;
+        std::function<bool(StreamedImage&)> decode;
+        std::function<void(const StreamedImage&)> onResident;
+        StreamedImage image;
+        bool decoded;
+    };
+    struct RingBuffer
+    {
+        GLuint buffer;
+        size_t capacity;
+        GLsync fence;
+    };
+
+    std::deque<std::unique_ptr<Job>> decoded;
+    mutable std::mutex mutex;
+    // the decode jobs not finished yet, the images on the upload thread
+    JobCounter decoding, uploading;
+    std::atomic<UploadThread*> uploads;
+    std::atomic<bool> stopping;
+    // requested but not resident, only touched by the render thread
+    int inFlight;
+
+    RingBuffer ring[RING_SIZE];
+    int nextBuffer;
+};
+
+#endif
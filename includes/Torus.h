@@ -29,9 +29,14 @@ public:
     Torus(float majorRadius=1.0f, float minorRadius=0.5f, int sectorCount=36, int sideCount=18, bool smooth=true, int up=3);
     ~Torus() {}
 
+    // pre-built resolution levels for LOD selection, finest first
+    static std::vector<Torus> buildLods(float majorRadius, float minorRadius, int sectorCount, int sideCount,
+                                        int levelCount=4, bool smooth=true, int up=3);
+
     // getters/setters
     float getMajorRadius() const            { return majorRadius; }
     float getMinorRadius() const            { return minorRadius; }
+    float getBoundingRadius() const         { return majorRadius + minorRadius; }
     int getSectorCount() const              { return sectorCount; }
     int getSideCount() const                { return sideCount; }
     int getUpAxis() const                   { return upAxis; }
@@ -0,0 +1,52 @@
+#ifndef UPLOAD_THREAD_H
+#define UPLOAD_THREAD_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "JobSystem.h"
+
+// A second GL context, sharing objects with the render thread's, on a thread of
+// its own. Big uploads (mesh buffers, texture images) run here and never hold up
+// a frame. A fence follows every upload, and the render thread has its command
+// stream wait on it (glWaitSync: on the GPU, the CPU goes on) before ready hands
+// the objects over. Buffers and textures are shared between the contexts, container
+// objects (VAOs, FBOs) are not, ready makes those.
+class UploadThread
+{
+public:
+	// window: hidden, shares objects with the render context, its own context current nowhere
+	explicit UploadThread(GLFWwindow* window, JobSystem& jobs = JobSystem::shared());
+	// runs what is queued, then joins
+	~UploadThread();
+	UploadThread(const UploadThread&) = delete;
+	UploadThread& operator=(const UploadThread&) = delete;
+
+	// work: on the upload thread; ready: on the GL thread (JobSystem::runGLJobs) once the
+	// render context may use what work made; counter (optional) stays up until ready ran
+	void upload(std::function<void()> work, std::function<void()> ready = nullptr, JobCounter* counter = nullptr);
+
+private:
+	struct Upload
+	{
+		std::function<void()> work, ready;
+		JobCounter* counter;
+	};
+
+	GLFWwindow* window;
+	JobSystem& jobs;
+	std::deque<Upload> queued;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping;
+	std::thread thread;
+
+	void run();
+};
+
+#endif
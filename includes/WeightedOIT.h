@@ -0,0 +1,31 @@
+#ifndef WEIGHTED_OIT_H
+#define WEIGHTED_OIT_H
+
+#include <glad/glad.h>
+
+// Weighted blended order independent transparency (McGuire & Bavoil).
+// Translucent surfaces are accumulated unsorted into two targets:
+// 0: sum of premultiplied color * weight, alpha * weight (RGBA16F)
+// 1: sum of -log(1 - alpha) (R16F), so the revealage product becomes a sum
+//    and both targets blend with GL_ONE, GL_ONE (3.3 has no per target blend state)
+// The scene depth is copied in first so opaque geometry still occludes.
+class WeightedOIT
+{
+public:
+	GLuint FBO;
+	GLuint accum, revealage, depthRBO;
+	unsigned int width, height;
+
+	WeightedOIT();
+	WeightedOIT(unsigned int width, unsigned int height);
+	// copies the depth of sceneFBO, clears and binds the targets with additive blending and no depth writes
+	// (only the bottom left viewWidth x viewHeight is drawn)
+	void begin(GLuint sceneFBO, unsigned int viewWidth, unsigned int viewHeight);
+	// restores sceneFBO and the state; the caller then draws the composite pass
+	void end(GLuint sceneFBO);
+	// binds accum and revealage to units firstUnit, +1 for the composite pass
+	void bindTextures(GLuint firstUnit);
+	void Delete();
+};
+
+#endif
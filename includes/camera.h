@@ -61,7 +61,7 @@ public:
         std::cout << this->Position.x << " " << this->Position.y <<  " " << this->Position.z << "\n";
     }
     // returns the view matrix calculated using Euler Angles and the LookAt Matrix
-    glm::mat4 GetViewMatrix()
+    glm::mat4 GetViewMatrix() const
     {
         return glm::lookAt(Position, Position + Front, Up);
     }
@@ -7,6 +7,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <shader.h>
+#include <AlphaMode.h>
 
 #include <string>
 #include <vector>
@@ -14,6 +15,10 @@ using namespace std;
 
 #define MAX_BONE_INFLUENCE 4
 
+// constant (per draw) vertex attribute holding the mesh's index in the MaterialTable
+#define MATERIAL_LOCATION 7
+// Texture::slot: 0 = 2D texture bound to a unit, 1..N = layer of texture array N-1
+
 struct Vertex {
     // position
     glm::vec3 Position;
@@ -35,6 +40,27 @@ struct Texture {
     unsigned int id;
     string type;
     string path;
+    // where the material shaders find it (see TextureArrays)
+    int slot = 0;
+    int layer = 0;
+    // classified when the image is decoded
+    int alphaMode = ALPHA_OPAQUE;
+};
+
+// one entry of the MaterialTable
+struct Material {
+    // diffuse slot, layer, specular slot, layer
+    glm::ivec4 textureSlots = glm::ivec4(0);
+    float shininess = 32.0f;
+    int alphaMode = ALPHA_CUTOUT;
+    // texture coordinate tiling
+    float textureCnt = 1.0f;
+
+    bool operator==(const Material& other) const
+    {
+        return textureSlots == other.textureSlots && shininess == other.shininess
+            && alphaMode == other.alphaMode && textureCnt == other.textureCnt;
+    }
 };
 
 class Mesh {
@@ -44,78 +70,109 @@ public:
     vector<unsigned int> indices;
     vector<Texture>      textures;
     unsigned int VAO;
+    Material material;
+    // index in the MaterialTable, 0 is the default material
+    int materialIndex;
 
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor (without setup no GL calls, e.g. off the GL thread; call createVertexArray() later)
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, bool setup = true)
     {
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        this->materialIndex = 0;
+        VAO = VBO = EBO = 0;
+        updateMaterialTextures();
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        if (setup) setupMesh();
+    }
+
+    // vertex and index buffers with their data, from any context sharing objects with the GL thread's
+    void createBuffers()
+    {
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        // a target that is no vertex array state, there may be no VAO bound here
+        glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
     }
 
-    // render the mesh
-    void Draw(Shader &shader) 
+    // GL thread: the vertex array of a mesh constructed without it (VAOs aren't shared
+    // between contexts), the buffers too unless createBuffers() made them already
+    void createVertexArray() { setupMesh(); }
+
+    // index buffer, also used by the position only shadow stream
+    unsigned int getEBO() const { return EBO; }
+
+    // picks the first diffuse and specular texture (specular falls back to diffuse),
+    // call again once the textures have been resolved to arrays
+    void updateMaterialTextures()
     {
-        // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to string
-             else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        const Texture* diffuse = nullptr;
+        const Texture* specular = nullptr;
+        for (const Texture& texture : textures) {
+            if (!diffuse && texture.type == "texture_diffuse") diffuse = &texture;
+            if (!specular && texture.type == "texture_specular") specular = &texture;
         }
-        
-        // draw mesh
+        if (!specular) specular = diffuse;
+        material.textureSlots = glm::ivec4(0);
+        textureIDs[0] = textureIDs[1] = 0;
+        if (!diffuse) return;
+        material.textureSlots = glm::ivec4(diffuse->slot, diffuse->layer, specular->slot, specular->layer);
+        textureIDs[0] = diffuse->id;
+        textureIDs[1] = specular->id;
+        // the shaders test diffuse.a + specular.a, one opaque texture keeps the sum opaque
+        material.alphaMode = glm::min(diffuse->alphaMode, specular->alphaMode);
+    }
+
+    // sets the material for the next draw; textures packed in arrays
+    // need no bind, the rest go to units 0 (texture_diffuse1) and 1 (texture_specular1)
+    void bindMaterial() const
+    {
+        glVertexAttribI1i(MATERIAL_LOCATION, materialIndex);
+        if (material.textureSlots.x == 0 && textureIDs[0]) {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, textureIDs[0]);
+        }
+        if (material.textureSlots.z == 0 && textureIDs[1]) {
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, textureIDs[1]);
+            glActiveTexture(GL_TEXTURE0);
+        }
+    }
+
+    // render the mesh with the shader in use (samplers: texture_diffuse1 = 0, texture_specular1 = 1)
+    void Draw() 
+    {
+        bindMaterial();
         glBindVertexArray(VAO);
         glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
     }
 
 private:
     // render data 
     unsigned int VBO, EBO;
+    // 2D textures bound when the material is not in an array
+    unsigned int textureIDs[2];
 
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
-        // create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        // create buffers (unless uploaded already)/arrays
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        if (!VBO) createBuffers();
+        glGenVertexArrays(1, &VAO);
 
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
         // set the vertex attribute pointers
         // vertex Positions
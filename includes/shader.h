@@ -17,33 +17,36 @@ public:
     // ------------------------------------------------------------------------
     Shader();
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
+    // same, with extra lines (#define / #extension) inserted after the #version line of every stage
+    Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines, const char* geometryPath = nullptr);
     // activate the shader
     // ------------------------------------------------------------------------
     void use();
-    // utility uniform functions
+    // utility uniform functions (names as C strings, a std::string per call allocates every frame)
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const;
+    void setBool(const char* name, bool value) const;
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value)const;
+    void setInt(const char* name, int value)const;
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value)const;
+    void setFloat(const char* name, float value)const;
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value)const;
-    void setVec2(const std::string &name, float x, float y)const;
+    void setVec2(const char* name, const glm::vec2 &value)const;
+    void setVec2(const char* name, float x, float y)const;
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value)const;
-    void setVec3(const std::string &name, float x, float y, float z)const;
+    void setVec3(const char* name, const glm::vec3 &value)const;
+    void setVec3(const char* name, float x, float y, float z)const;
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value)const;
-    void setVec4(const std::string &name, float x, float y, float z, float w)const;
+    void setVec4(const char* name, const glm::vec4 &value)const;
+    void setVec4(const char* name, float x, float y, float z, float w)const;
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat)const;
+    void setMat2(const char* name, const glm::mat2 &mat)const;
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat)const;
+    void setMat3(const char* name, const glm::mat3 &mat)const;
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat)const;
+    void setMat4(const char* name, const glm::mat4 &mat)const;
 
 private:
+    void load(const char* vertexPath, const char* fragmentPath, const char* geometryPath, const std::string& defines);
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type);
@@ -0,0 +1,78 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+// a plain counter, a thread_local with a constructor could allocate itself
+static thread_local size_t allocations = 0;
+
+size_t AllocationCounter::thisThread()
+{
+	return allocations;
+}
+
+static void* countedAllocate(size_t size)
+{
+	allocations++;
+	while (true) {
+		if (void* memory = std::malloc(size ? size : 1)) return memory;
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) return nullptr;
+		handler();
+	}
+}
+
+// the aligned forms keep the library's own (its delete has to match)
+void* operator new(size_t size)
+{
+	if (void* memory = countedAllocate(size)) return memory;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	try {
+		return countedAllocate(size);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
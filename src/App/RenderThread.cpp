@@ -0,0 +1,109 @@
+#include "App/RenderThread.h"
+#include <memory>
+
+RenderThread::RenderThread(GLFWwindow* window, const Settings& settings)
+	: window(window), settings(settings), stopping(false), idle(false), glWork(false), submitted(0), judged(0)
+{
+	thread = std::thread(&RenderThread::run, this);
+}
+
+RenderThread::~RenderThread()
+{
+	stop();
+}
+
+void RenderThread::submit(FrameInput&& input)
+{
+	{
+		std::unique_lock<std::mutex> lock(wakeMutex);
+		frameTaken.wait(lock, [this] { return !queue.full(); });
+	}
+	// the only producer: the slot stays free
+	queue.tryPush(std::move(input));
+	notify(frameQueued);
+	if (!settings.onDemand) return;
+	// idle has to be the verdict on this input, not on the one before
+	std::unique_lock<std::mutex> lock(wakeMutex);
+	submitted++;
+	frameJudged.wait(lock, [this] { return judged == submitted; });
+}
+
+void RenderThread::stop()
+{
+	if (!thread.joinable()) return;
+	stopping.store(true, std::memory_order_release);
+	notify(frameQueued);
+	thread.join();
+}
+
+// after the change it wakes for, under the mutex, so a waiter can't check
+// its condition before the change and sleep through the notification
+void RenderThread::notify(std::condition_variable& condition)
+{
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+	}
+	condition.notify_one();
+}
+
+void RenderThread::run()
+{
+	glfwMakeContextCurrent(window);
+	glfwSwapInterval(settings.swapInterval);
+	// jobs that need the context queue their GL calls for this thread
+	JobSystem::shared().setGLThread();
+	JobSystem::shared().setGLWake([this] {
+		{
+			std::lock_guard<std::mutex> lock(wakeMutex);
+			glWork = true;
+		}
+		frameQueued.notify_one();
+		// render on demand: the main thread may be waiting for events, the result needs a frame
+		if (settings.onDemand) glfwPostEmptyEvent();
+	});
+	// outlives the renderer, whose loads wait for their uploads when it goes
+	std::unique_ptr<UploadThread> uploads;
+	if (settings.uploadContext) uploads.reset(new UploadThread(settings.uploadContext));
+	{
+		// resources are created here, on the thread that owns the context
+		Renderer renderer(settings.renderPath, settings.antiAliasing, uploads.get());
+		double refreshInterval = settings.minRefresh > 0.0 ? 1.0 / settings.minRefresh : 1e9;
+		double lastPresent = glfwGetTime();
+		FrameInput input;
+		while (true) {
+			if (!queue.tryPop(input)) {
+				if (stopping.load(std::memory_order_acquire)) break;
+				{
+					std::unique_lock<std::mutex> lock(wakeMutex);
+					frameQueued.wait(lock, [this] {
+						return !queue.empty() || glWork || stopping.load(std::memory_order_acquire);
+					});
+					glWork = false;
+				}
+				// finished loads hand over their GL work without waiting for a frame
+				JobSystem::shared().runGLJobs();
+				continue;
+			}
+			notify(frameTaken);
+			JobSystem::shared().runGLJobs();
+			renderer.applyInput(input);
+			bool draw = !settings.onDemand || renderer.needsRender(input);
+			idle.store(!draw, std::memory_order_release);
+			if (settings.onDemand) {
+				{
+					std::lock_guard<std::mutex> lock(wakeMutex);
+					judged++;
+				}
+				frameJudged.notify_one();
+			}
+			if (draw) renderer.render(input);
+			else if (input.windowChanged || glfwGetTime() >= lastPresent + refreshInterval) renderer.presentLast(input);
+			else continue;
+			lastPresent = glfwGetTime();
+			glfwSwapBuffers(window);
+		}
+	}
+	JobSystem::shared().setGLWake(nullptr);
+	uploads.reset();
+	glfwMakeContextCurrent(nullptr);
+}
@@ -1,69 +1,516 @@
 #include "App/Renderer.h"
 #include "Light.h"
+#include "AllocationCounter.h"
+#include <cassert>
 
-Renderer::Renderer()
+bool FrameSnapshot::operator==(const FrameSnapshot& other) const
 {
-    ResourceManager resourceManager;
-    //texture:
-    textures = resourceManager.textures;
-    //shaders:
-    shaders = resourceManager.shaders;
-    //light
-    light = Light(shaders[MAIN], true, 0, true);
+    return cameraPosition == other.cameraPosition && cameraFront == other.cameraFront && cameraUp == other.cameraUp
+        && cameraZoom == other.cameraZoom && lightVersion == other.lightVersion
+        && instanceVersion == other.instanceVersion && isNight == other.isNight;
+}
+
+Renderer::Renderer(RenderPath renderPath, AntiAliasing antiAliasingMode, UploadThread* uploads) : Scene(uploads), renderPath(renderPath), skybox(&textureStreamer), drawLists(&JobSystem::shared(), &frameMemory)
+{
+    //mip streaming (before the materials build the arrays):
+    textureArrays.setMemoryBudget(TEXTURE_MEMORY_BUDGET);
+    //shaders and textures (the shaders compile on the GL thread while the workers import the models):
+    loading.add(RESOURCES, nullptr, [this] {
+        ResourceManager resourceManager("", &textureStreamer);
+        //texture:
+        textures = resourceManager.textures;
+        //shaders:
+        shaders = resourceManager.shaders;
+        //light (its uniforms live in the shaders that do the lighting)
+        if (this->renderPath == RenderPath::Deferred) {
+            light = Light(shaders[DEFERRED_LIGHTING], true, 0, true);
+        } else {
+            light = Light(shaders[MAIN], true, 0, true);
+            light.addShader(shaders[MAIN_CUTOUT]);
+        }
+        light.addShader(shaders[MAIN_BLEND]);
+    });
+    //impostors, baked once the model and its materials are in:
+    loading.add(IMPOSTORS, nullptr, [this] {
+        shaders[IMPOSTOR_BAKE].use();
+        textureArrays.bind(shaders[IMPOSTOR_BAKE]);
+        materials.bind(shaders[IMPOSTOR_BAKE]);
+        impostorBuffers(TRANSFORMER, shaders[IMPOSTOR_BAKE]);
+        //the model shows up now, on demand rendering has to see it
+        instanceVersion++;
+    }, { RESOURCES, MATERIALS });
+    //deferred:
+    if (renderPath == RenderPath::Deferred) gBuffer = GBuffer(SCR_WIDTH, SCR_HEIGHT);
+    //transparency:
+    transparency = WeightedOIT(SCR_WIDTH, SCR_HEIGHT);
+    //dynamic resolution:
+    resolution = DynamicResolution(SCR_WIDTH, SCR_HEIGHT, GPU_FRAME_BUDGET, antiAliasingMode == AntiAliasing::MSAA ? MSAA_SAMPLES : 1);
+    //anti-aliasing:
+    antiAliasing = PostAntiAliasing(SCR_WIDTH, SCR_HEIGHT, antiAliasingMode);
+    //the first frame only needs the shaders, the objects show up as they finish loading:
+    loading.wait(RESOURCES);
 
 }
 
 
-void Renderer::render(Controller& controller)
+void Renderer::applyInput(const FrameInput& input)
+{
+    for (auto& update : input.instanceUpdates)
+        setInstances(update.first, update.second);
+    if (input.pointLightsChanged) {
+        light.pointLights = input.pointLights;
+        light.turnOnPoint();
+    }
+}
+
+void Renderer::render(const FrameInput& input)
 {
-    Camera camera = controller.getCamera();
+    //the last frame's jobs are done, so is its transient memory:
+    frameMemory.reset();
+    //allocations of this thread and of the draw list jobs, wherever they run:
+    size_t allocations = AllocationCounter::thisThread();
+    drawLists.takeJobAllocations();
+    int streamingBefore = textureStreamer.pending();
+    const Camera& camera = input.camera;
+    //STREAMING (the impostors were baked from placeholders, bake again once everything is in):
+    if (updateStreaming() && impostors.count(TRANSFORMER))
+        impostors[TRANSFORMER].rebake(threeDModels[TRANSFORMER], shaders[IMPOSTOR_BAKE]);
+
+    //SCENE TARGET at the scale the last GPU timings allow:
+    GLint windowViewport[4] = { 0, 0, input.framebufferWidth, input.framebufferHeight };
+    resolution.begin();
+    renderSize = glm::vec2(resolution.renderWidth(), resolution.renderHeight());
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // also clear the depth buffer now!
     
     glGetError();
 
-    //MAIN
-    shaders[MAIN].use();
-    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, Z_NEAR, Z_FAR);
     glm::mat4 view = camera.GetViewMatrix();
-    shaders[MAIN].setMat4("projection", projection);
-    shaders[MAIN].setMat4("view", view);
-    shaders[MAIN].setFloat("shininess", 32.0f);
-    shaders[MAIN].setFloat("alpha", 1.0f);
-    
+    //TAA: every pass below sees the sub-pixel jitter of this frame
+    glm::mat4 viewProjection = projection * view;
+    Frustum frustum(viewProjection);
+    projection = antiAliasing.jitterProjection(projection, renderSize);
+    lightClusters.update(light.pointLights, view, glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, Z_NEAR, Z_FAR, &frameMemory);
+
+    //SHADOWS:
+    renderShadows(camera);
 
+    //GEOMETRY, one pipeline per alpha class (forward: MAIN* shade directly, deferred: GBUFFER* only fill the G-buffer)
+    bool deferred = renderPath == RenderPath::Deferred;
+    Shader& opaqueShader = deferred ? shaders[GBUFFER] : shaders[MAIN];
+    Shader& cutoutShader = deferred ? shaders[GBUFFER_CUTOUT] : shaders[MAIN_CUTOUT];
+    Shader& blendShader = shaders[MAIN_BLEND];
     //Light:
     light.update(camera.Position, camera.Front);
     light.turnOnSpot();
+    setupMaterialShader(opaqueShader, projection, view, camera.Position, !deferred);
+    setupMaterialShader(cutoutShader, projection, view, camera.Position, !deferred);
+    setupMaterialShader(blendShader, projection, view, camera.Position, true);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (deferred) {
+        gBuffer.Bind(resolution.renderWidth(), resolution.renderHeight());
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
 
-    
-    //TRANSFORMER:
-    draw3Dmodel(TRANSFORMER);
+    //TRANSFORMER (near instances as meshes, far ones as impostors), once it has loaded:
+    float pixelsPerUnit = renderSize.y / (2.0f * glm::tan(glm::radians(camera.Zoom) * 0.5f));
+    bool transformerLoaded = loading.done(IMPOSTORS);
+    if (transformerLoaded) {
+        splitImpostorInstances(TRANSFORMER, camera.Position, view, frustum);
+        requestTextureDetail(TRANSFORMER, camera.Position, pixelsPerUnit);
+        GLsizei fadingCount = (GLsizei)meshInstances.size() - solidInstanceCount;
+        opaqueShader.use();
+        draw3Dmodel(TRANSFORMER, 0, solidInstanceCount, 1 << ALPHA_OPAQUE);
+        cutoutShader.use();
+        draw3Dmodel(TRANSFORMER, 0, solidInstanceCount, 1 << ALPHA_CUTOUT);
+        //instances fading to the impostor need the dithered discard as well:
+        cutoutShader.setVec2("lodFade", IMPOSTOR_FADE);
+        draw3Dmodel(TRANSFORMER, solidInstanceCount, fadingCount, (1 << ALPHA_OPAQUE) | (1 << ALPHA_CUTOUT));
+        cutoutShader.setVec2("lodFade", glm::vec2(0.0f));
+    }
 
-    
-    // draw skybox as last
-    skybox.setEnvironment(!controller.isNight);
+    //LOD primitives (blue metal, alpha tested), every level of every mesh in one submission:
+    if (!lodMeshes.empty()) {
+        size_t lodInstanceCount = 0;
+        for (auto& lod : lodMeshes) lodInstanceCount += models[lod.first].size();
+        FrameVector<glm::mat4> lodInstances(&frameMemory);
+        FrameVector<PrimitiveRegistry::Draw> lodDraws(&frameMemory);
+        lodInstances.reserve(lodInstanceCount);
+        for (auto& lod : lodMeshes)
+            addLodDraws(lod.first, view, frustum, pixelsPerUnit, lodInstances, lodDraws);
+        cutoutShader.use();
+        TextureManager::enable(textures[BLUE_METAL], textures[BLUE_METAL_SPEC], 0);
+        primitives.setInstances(0, lodInstances.data(), (GLsizei)lodInstances.size());
+        primitives.draw(lodDraws.data(), lodDraws.size());
+    }
+
+    //DEFERRED LIGHTING (fullscreen, also restores the scene depth for the passes below)
+    if (deferred) {
+        gBuffer.Unbind(resolution.FBO);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        Shader& lightingShader = shaders[DEFERRED_LIGHTING];
+        lightingShader.use();
+        gBuffer.bindTextures(0);
+        lightingShader.setInt("gAlbedoSpec", 0);
+        lightingShader.setInt("gNormal", 1);
+        lightingShader.setInt("gDepth", 2);
+        lightingShader.setMat4("inverseViewProjection", glm::inverse(projection * view));
+        lightClusters.bind(lightingShader, renderSize);
+        shadows.bind(lightingShader);
+        lightingShader.setBool("enableDynamicShadows", !dynamicModels.empty());
+        glDepthFunc(GL_ALWAYS);
+        fullscreenTriangle.draw();
+        glDepthFunc(GL_LESS);
+    }
+
+    //IMPOSTORS:
+    shaders[IMPOSTOR].use();
+    shaders[IMPOSTOR].setMat4("projection", projection);
+    shaders[IMPOSTOR].setMat4("view", view);
+    shaders[IMPOSTOR].setVec3("viewPos", camera.Position);
+    shaders[IMPOSTOR].setBool("enableDir", light.enableDir);
+    shaders[IMPOSTOR].setVec3("dirLight.direction", light.dirLightDirection);
+    shaders[IMPOSTOR].setVec3("dirLight.ambient", light.dirLightAmbient);
+    shaders[IMPOSTOR].setVec3("dirLight.diffuse", light.dirLightDiffuse);
+    if (transformerLoaded) impostors[TRANSFORMER].draw(shaders[IMPOSTOR], impostorInstances, IMPOSTOR_FADE);
+
+    // draw skybox after the opaque passes (only where the depth is still at the far plane)
+    float nightStep = input.deltaTime / SKY_TRANSITION_TIME;
+    nightAmount = input.isNight ? glm::min(nightAmount + nightStep, 1.0f) : glm::max(nightAmount - nightStep, 0.0f);
+    skybox.setNight(nightAmount);
     skybox.draw(shaders[SKYBOX], view, projection);
 
-    
+    //TRANSLUCENT meshes last (over every opaque pass and the sky), forward shaded into
+    //the OIT targets in one unsorted draw, then composited:
+    if (transformerLoaded && hasTranslucent(TRANSFORMER)) {
+        transparency.begin(resolution.FBO, resolution.renderWidth(), resolution.renderHeight());
+        blendShader.use();
+        blendShader.setVec2("lodFade", IMPOSTOR_FADE);
+        draw3Dmodel(TRANSFORMER, 0, (GLsizei)meshInstances.size(), 1 << ALPHA_BLEND);
+        transparency.end(resolution.FBO);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+        Shader& compositeShader = shaders[OIT_COMPOSITE];
+        compositeShader.use();
+        transparency.bindTextures(0);
+        compositeShader.setInt("accum", 0);
+        compositeShader.setInt("revealage", 1);
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        fullscreenTriangle.draw();
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    //ANTI-ALIASING and UPSCALE to the window (the GPU time of the scene picks the next scales):
+    resolution.end();
+    lastSceneTexture = antiAlias(viewProjection, projection * view);
+    present(windowViewport, lastSceneTexture);
+    if (settleFrames > 0) settleFrames--;
+
+    //STEADY STATE: with everything loaded and no texture coming in, a frame allocates nothing (its jobs neither)
+    bool steady = loading.allDone() && streamingBefore == 0 && textureStreamer.pending() == 0 && !frameMemory.overflowed();
+    size_t jobAllocations = drawLists.takeJobAllocations();
+    assert(!(steady && steadyFrames >= STEADY_WARMUP) || (AllocationCounter::thisThread() == allocations && jobAllocations == 0));
+    steadyFrames = steady ? steadyFrames + 1 : 0;
 }
-void Renderer::draw(string objectName, int numOfVertices)
+
+bool Renderer::needsRender(const FrameInput& input)
 {
-    vaos[objectName].Bind(); ebos[objectName].Bind();
-    glDrawElementsInstanced(GL_TRIANGLES, numOfVertices, GL_UNSIGNED_INT, (void*)0, models[objectName].size());  
+    const Camera& camera = input.camera;
+    FrameSnapshot frame = { camera.Position, camera.Front, camera.Up, camera.Zoom, light.version, instanceVersion, input.isNight };
+    float targetNight = input.isNight ? 1.0f : 0.0f;
+    //moving instances, a sky transition, arriving textures or models still loading change the image without a state change:
+    bool changed = !(frame == lastFrame) || !dynamicModels.empty() || nightAmount != targetNight
+        || textureStreamer.pending() > 0 || !loading.allDone() || lastSceneTexture == 0;
+    lastFrame = frame;
+    if (changed)
+        settleFrames = antiAliasing.mode == AntiAliasing::TAA ? TAA_SETTLE_FRAMES : SETTLE_FRAMES;
+    return settleFrames > 0;
+}
 
+void Renderer::presentLast(const FrameInput& input)
+{
+    GLint windowViewport[4] = { 0, 0, input.framebufferWidth, input.framebufferHeight };
+    present(windowViewport, lastSceneTexture);
 }
-void Renderer::draw3Dmodel(string name)
+void Renderer::draw3Dmodel(const string& name, GLsizei firstInstance, GLsizei instanceCount, unsigned int alphaModes)
 {
-    shaders[MAIN].setFloat("textureCnt", 1.0f);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, threeDModels[name].textures_loaded[0].id); // note: we also made the textures_loaded vector public (instead of private) from the model class.
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, threeDModels[name].textures_loaded[1].id); // note: we also made the textures_loaded vector public (instead of private) from the model class.
+    if (instanceCount <= 0) return;
+    setInstanceOffset(name, firstInstance);
+    // materials come from the table and texture arrays bound for the pass, only the index changes per mesh
     for (unsigned int i = 0; i < threeDModels[name].meshes.size(); i++)
     {
+        if (!(alphaModes & (1u << threeDModels[name].meshes[i].material.alphaMode))) continue;
+        threeDModels[name].meshes[i].bindMaterial();
         glBindVertexArray(threeDModels[name].meshes[i].VAO);
-        glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(threeDModels[name].meshes[i].indices.size()), GL_UNSIGNED_INT, 0, models[name].size());
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(threeDModels[name].meshes[i].indices.size()), GL_UNSIGNED_INT, 0, instanceCount);
         glBindVertexArray(0);
     }
-}
\ No newline at end of file
+    // back to the default material (bound texture_diffuse1 / texture_specular1) for primitives
+    glVertexAttribI1i(MATERIAL_LOCATION, 0);
+}
+bool Renderer::hasTranslucent(const string& name)
+{
+    for (const Mesh& mesh : threeDModels[name].meshes)
+        if (mesh.material.alphaMode == ALPHA_BLEND) return true;
+    return false;
+}
+void Renderer::setupMaterialShader(Shader& shader, const glm::mat4& projection, const glm::mat4& view, glm::vec3 viewPos, bool lit)
+{
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+    shader.setVec3("viewPos", viewPos);
+    shader.setFloat("alpha", 1.0f);
+    shader.setVec2("lodFade", glm::vec2(0.0f));
+    textureArrays.bind(shader);
+    materials.bind(shader);
+    if (lit) {
+        lightClusters.bind(shader, renderSize);
+        shadows.bind(shader);
+        shader.setBool("enableDynamicShadows", !dynamicModels.empty());
+    }
+}
+void Renderer::renderShadows(const Camera& camera)
+{
+    //static cascades only when invalidated, dynamic casters every frame:
+    unsigned int staticCascades = shadows.update(camera, (float)SCR_WIDTH / (float)SCR_HEIGHT, Z_NEAR, SHADOW_DISTANCE, light.dirLightDirection, staticVersion);
+    bool hasDynamic = !dynamicModels.empty();
+    if (!staticCascades && !hasDynamic) return;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    Shader& depthShader = shaders[SHADOW_DEPTH];
+    depthShader.use();
+    for (int cascade = 0; cascade < CascadedShadows::CASCADES; cascade++)
+    {
+        if (!(staticCascades & (1u << cascade))) continue;
+        shadows.beginStatic(cascade);
+        depthShader.setMat4("lightSpace", shadows.staticLightSpace[cascade]);
+        drawShadowCasters(false);
+    }
+    if (hasDynamic)
+        for (int cascade = 0; cascade < CascadedShadows::CASCADES; cascade++)
+        {
+            shadows.beginDynamic(cascade);
+            depthShader.setMat4("lightSpace", shadows.dynamicLightSpace[cascade]);
+            drawShadowCasters(true);
+        }
+    shadows.end(viewport, resolution.FBO);
+}
+
+void Renderer::drawShadowCasters(bool dynamic)
+{
+    for (auto& casters : shadowCasters)
+    {
+        if ((dynamicModels.count(casters.first) > 0) != dynamic) continue;
+        GLsizei instanceCount = (GLsizei)models[casters.first].size();
+        for (ShadowCaster& caster : casters.second)
+        {
+            glBindVertexArray(caster.VAO);
+            glDrawElementsInstanced(GL_TRIANGLES, caster.indexCount, GL_UNSIGNED_INT, 0, instanceCount);
+        }
+    }
+    glBindVertexArray(0);
+}
+
+void Renderer::splitImpostorInstances(const string& name, glm::vec3 viewPos, const glm::mat4& view, const Frustum& frustum)
+{
+    //buckets: 0 solid meshes, 1 meshes fading to the impostor, 2 impostors (the fading ones again and the far ones)
+    const vector<glm::mat4>& instances = models[name];
+    glm::vec4 bounds = modelBounds[name];
+    const FrameVector<DrawItem>& items = drawLists.build(instances.size(), [&](size_t begin, size_t end, size_t, FrameVector<DrawItem>& out) {
+        for (size_t i = begin; i < end; i++)
+        {
+            const glm::mat4& model = instances[i];
+            float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+            glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(bounds), 1.0f));
+            if (!frustum.intersectsSphere(center, bounds.w * scale)) continue;
+            float distance = glm::length(glm::vec3(model[3]) - viewPos);
+            float depth = -(view * glm::vec4(center, 1.0f)).z;
+            if (distance <= IMPOSTOR_FADE.x) out.push_back({ DrawListBuilder::sortKey(0, depth, Z_FAR), (uint32_t)i });
+            else if (distance < IMPOSTOR_FADE.y) out.push_back({ DrawListBuilder::sortKey(1, depth, Z_FAR), (uint32_t)i });
+            if (distance > IMPOSTOR_FADE.x) out.push_back({ DrawListBuilder::sortKey(2, depth, Z_FAR), (uint32_t)i });
+        }
+    });
+
+    //the list is ordered by bucket, so meshes come first, the solid ones first among them:
+    size_t meshCount = 0;
+    solidInstanceCount = 0;
+    for (const DrawItem& item : items)
+    {
+        if (DrawListBuilder::bucket(item) == 2) break;
+        if (DrawListBuilder::bucket(item) == 0) solidInstanceCount++;
+        meshCount++;
+    }
+    //room for every instance once, so moving the camera never grows them:
+    meshInstances.reserve(instances.size());
+    impostorInstances.reserve(instances.size());
+    meshInstances.resize(meshCount);
+    impostorInstances.resize(items.size() - meshCount);
+    drawLists.forEachRange(items.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            (i < meshCount ? meshInstances[i] : impostorInstances[i - meshCount]) = instances[items[i].instance];
+    });
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffers[name]);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, meshInstances.size() * sizeof(glm::mat4), meshInstances.data());
+}
+
+GLuint Renderer::antiAlias(const glm::mat4& viewProjection, const glm::mat4& jitteredViewProjection)
+{
+    //MSAA was resolved by resolution.end():
+    if (antiAliasing.mode != AntiAliasing::FXAA && antiAliasing.mode != AntiAliasing::TAA) return resolution.color;
+
+    glm::vec2 texelSize(1.0f / resolution.width, 1.0f / resolution.height);
+    glDisable(GL_DEPTH_TEST);
+    resolution.bindTexture(0);
+    if (antiAliasing.mode == AntiAliasing::FXAA) {
+        antiAliasing.bindOutput(antiAliasing.outputFBO, renderSize);
+        Shader& fxaaShader = shaders[FXAA];
+        fxaaShader.use();
+        fxaaShader.setInt("scene", 0);
+        fxaaShader.setVec2("uvScale", resolution.uvScale());
+        fxaaShader.setVec2("texelSize", texelSize);
+        fullscreenTriangle.draw();
+    } else {
+        //camera motion from the scene depth:
+        antiAliasing.bindOutput(antiAliasing.velocityFBO, renderSize);
+        Shader& velocityShader = shaders[TAA_VELOCITY];
+        velocityShader.use();
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, resolution.depth);
+        velocityShader.setInt("depth", 1);
+        velocityShader.setMat4("inverseViewProjection", glm::inverse(jitteredViewProjection));
+        velocityShader.setMat4("previousViewProjection", antiAliasing.previousViewProjection());
+        velocityShader.setVec2("screenSize", renderSize);
+        fullscreenTriangle.draw();
+
+        //this frame into the history it reprojects:
+        antiAliasing.bindOutput(antiAliasing.historyFBO[antiAliasing.current], renderSize);
+        Shader& resolveShader = shaders[TAA_RESOLVE];
+        resolveShader.use();
+        glBindTexture(GL_TEXTURE_2D, antiAliasing.velocity);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, antiAliasing.history[1 - antiAliasing.current]);
+        glActiveTexture(GL_TEXTURE0);
+        resolveShader.setInt("scene", 0);
+        resolveShader.setInt("velocity", 1);
+        resolveShader.setInt("history", 2);
+        resolveShader.setVec2("texelSize", texelSize);
+        resolveShader.setVec2("uvScale", resolution.uvScale());
+        resolveShader.setVec2("previousUvScale", antiAliasing.previousUvScale());
+        resolveShader.setBool("historyValid", antiAliasing.historyValid());
+        resolveShader.setFloat("feedback", TAA_FEEDBACK);
+        fullscreenTriangle.draw();
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    GLuint result = antiAliasing.result();
+    antiAliasing.endFrame(viewProjection, resolution.uvScale());
+    return result;
+}
+
+void Renderer::present(const GLint windowViewport[4], GLuint sceneTexture)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(windowViewport[0], windowViewport[1], windowViewport[2], windowViewport[3]);
+    Shader& upscaleShader = shaders[UPSCALE];
+    upscaleShader.use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sceneTexture);
+    upscaleShader.setInt("scene", 0);
+    upscaleShader.setVec2("uvScale", resolution.uvScale());
+    upscaleShader.setVec2("texelSize", glm::vec2(1.0f / resolution.width, 1.0f / resolution.height));
+    //nothing to win back at full resolution:
+    float lost = (1.0f - resolution.scale) / (1.0f - DynamicResolution::MIN_SCALE);
+    upscaleShader.setFloat("sharpness", UPSCALE_SHARPNESS * lost);
+    glDisable(GL_DEPTH_TEST);
+    fullscreenTriangle.draw();
+    glEnable(GL_DEPTH_TEST);
+}
+
+void Renderer::requestTextureDetail(const string& name, glm::vec3 viewPos, float pixelsPerUnit)
+{
+    //the impostors carry their own baked textures, only mesh instances count:
+    float nearest = -1.0f, scale = 1.0f;
+    for (const glm::mat4& model : meshInstances)
+    {
+        float distance = glm::length(glm::vec3(model[3]) - viewPos);
+        if (nearest >= 0.0f && distance >= nearest) continue;
+        nearest = distance;
+        scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    }
+    if (nearest < 0.0f) return;
+
+    //a mesh's textures are assumed to cover it once (a tiled one repeats, so each copy is smaller):
+    Model& model = threeDModels[name];
+    for (size_t i = 0; i < model.meshes.size(); i++)
+    {
+        float radius = meshRadii[name][i] * scale;
+        float screenPixels = 2.0f * radius * pixelsPerUnit / glm::max(nearest - radius, Z_NEAR);
+        for (const Texture& texture : model.meshes[i].textures)
+            textureArrays.requestDetail(texture, screenPixels / glm::max(model.meshes[i].material.textureCnt, 1.0f));
+    }
+}
+
+void Renderer::addLodDraws(const string& name, const glm::mat4& view, const Frustum& frustum, float pixelsPerUnit,
+                           FrameVector<glm::mat4>& instanceData, FrameVector<PrimitiveRegistry::Draw>& draws)
+{
+    LodMesh& lod = lodMeshes[name];
+    const vector<glm::mat4>& instances = models[name];
+    if (lod.levels.empty()) return;
+
+    //projected radius in pixels (negative for culled instances), and the triangles every bias step would cost:
+    FrameVector<float> lodScreenRadius(instances.size(), &frameMemory), lodDepth(instances.size(), &frameMemory);
+    FrameVector<array<unsigned long long, LOD_BIAS_STEPS>> lodTriangles(drawLists.jobCount(instances.size()), {}, &frameMemory);
+    drawLists.forEachRange(instances.size(), [&](size_t begin, size_t end) {
+        array<unsigned long long, LOD_BIAS_STEPS>& triangles = lodTriangles[begin / DrawListBuilder::GRAIN];
+        for (size_t i = begin; i < end; i++)
+        {
+            const glm::mat4& model = instances[i];
+            float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+            float radius = lod.boundingRadius * scale;
+            lodDepth[i] = -(view * model[3]).z;
+            bool visible = frustum.intersectsSphere(glm::vec3(model[3]), radius);
+            lodScreenRadius[i] = visible ? radius * pixelsPerUnit / glm::max(lodDepth[i], 0.1f) : -1.0f;
+            if (!visible) continue;
+            float bias = 1.0f;
+            for (int step = 0; step < LOD_BIAS_STEPS; step++, bias *= 2.0f)
+                triangles[step] += lod.getTriangleCount(lod.selectLevel(lodScreenRadius[i], bias));
+        }
+    });
+
+    //the finest bias that keeps the budget (the coarsest if none does):
+    int step = 0;
+    for (; step < LOD_BIAS_STEPS - 1; step++)
+    {
+        unsigned long long triangles = 0;
+        for (const auto& job : lodTriangles) triangles += job[step];
+        if (triangles <= LOD_TRIANGLE_BUDGET) break;
+    }
+    float bias = (float)(1 << step);
+
+    //one bucket per level, front to back inside it:
+    const FrameVector<DrawItem>& items = drawLists.build(instances.size(), [&](size_t begin, size_t end, size_t, FrameVector<DrawItem>& out) {
+        for (size_t i = begin; i < end; i++)
+            if (lodScreenRadius[i] >= 0.0f)
+                out.push_back({ DrawListBuilder::sortKey(lod.selectLevel(lodScreenRadius[i], bias), lodDepth[i], Z_FAR), (uint32_t)i });
+    });
+    FrameVector<size_t> firstItem(lod.levels.size() + 1, items.size(), &frameMemory);
+    for (size_t i = items.size(); i-- > 0;) firstItem[DrawListBuilder::bucket(items[i])] = i;
+    for (size_t level = lod.levels.size(); level-- > 0;) firstItem[level] = glm::min(firstItem[level], firstItem[level + 1]);
+    //the list is ordered by level, so every level's instances are already one range of it:
+    size_t base = instanceData.size();
+    instanceData.resize(base + items.size());
+    drawLists.forEachRange(items.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            instanceData[base + i] = instances[items[i].instance];
+    });
+    for (size_t level = 0; level < lod.levels.size(); level++)
+        if (firstItem[level + 1] > firstItem[level])
+            draws.push_back({ lod.levels[level].primitive, (GLuint)(base + firstItem[level]), (GLsizei)(firstItem[level + 1] - firstItem[level]) });
+}
@@ -1,38 +1,57 @@
 #include "App/ResourceManager.h"
 
-ResourceManager::ResourceManager()
+ResourceManager::ResourceManager(const string& materialDefines, TextureStreamer* streamer)
 {
-    setShaders();
-    setTextures();
+    setShaders(materialDefines);
+    setTextures(streamer);
 }
 
-void ResourceManager::setShaders()
+void ResourceManager::setShaders(const string& materialDefines)
 {
-    //MAIN:
-    shaders[MAIN] = Shader("../src/shaders/mainShader.vs", "../src/shaders/mainShader.fs");
+    //MAIN, one pipeline per alpha class:
+    string cutoutDefines = materialDefines + "\n#define ALPHA_TEST", blendDefines = materialDefines + "\n#define ALPHA_BLEND";
+    shaders[MAIN] = Shader("../src/shaders/mainShader.vs", "../src/shaders/mainShader.fs", materialDefines);
+    shaders[MAIN_CUTOUT] = Shader("../src/shaders/mainShader.vs", "../src/shaders/mainShader.fs", cutoutDefines);
+    shaders[MAIN_BLEND] = Shader("../src/shaders/mainShader.vs", "../src/shaders/mainShader.fs", blendDefines);
     //SKYBOX:
     shaders[SKYBOX] = Shader("../src/shaders/skybox.vs", "../src/shaders/skybox.fs");
+    //IMPOSTOR:
+    shaders[IMPOSTOR] = Shader("../src/shaders/impostor.vs", "../src/shaders/impostor.fs");
+    shaders[IMPOSTOR_BAKE] = Shader("../src/shaders/impostorBake.vs", "../src/shaders/impostorBake.fs", materialDefines);
+    //DEFERRED:
+    shaders[GBUFFER] = Shader("../src/shaders/mainShader.vs", "../src/shaders/gbuffer.fs", materialDefines);
+    shaders[GBUFFER_CUTOUT] = Shader("../src/shaders/mainShader.vs", "../src/shaders/gbuffer.fs", cutoutDefines);
+    shaders[DEFERRED_LIGHTING] = Shader("../src/shaders/fullscreen.vs", "../src/shaders/deferredLighting.fs");
+    //SHADOWS:
+    shaders[SHADOW_DEPTH] = Shader("../src/shaders/shadowDepth.vs", "../src/shaders/shadowDepth.fs");
+    //TRANSPARENCY:
+    shaders[OIT_COMPOSITE] = Shader("../src/shaders/fullscreen.vs", "../src/shaders/oitComposite.fs");
+    //DYNAMIC RESOLUTION:
+    shaders[UPSCALE] = Shader("../src/shaders/fullscreen.vs", "../src/shaders/upscale.fs");
+    //ANTI-ALIASING:
+    shaders[FXAA] = Shader("../src/shaders/fullscreen.vs", "../src/shaders/fxaa.fs");
+    shaders[TAA_VELOCITY] = Shader("../src/shaders/fullscreen.vs", "../src/shaders/taaVelocity.fs");
+    shaders[TAA_RESOLVE] = Shader("../src/shaders/fullscreen.vs", "../src/shaders/taaResolve.fs");
 
 }
 
-void ResourceManager::setTextures()
+void ResourceManager::setTextures(TextureStreamer* streamer)
 {   
-    stbi_set_flip_vertically_on_load(true);
 
     //blue metal
-    textures[BLUE_METAL] = TextureManager("../resources/textures/blue_metal_plate_diff_1k.png", GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE);
-    textures[BLUE_METAL_SPEC] = TextureManager("../resources/textures/blue_metal_plate_rough_1k.png", GL_TEXTURE_2D, GL_TEXTURE1, GL_RGBA, GL_UNSIGNED_BYTE);
+    textures[BLUE_METAL] = TextureManager("../resources/textures/blue_metal_plate_diff_1k.png", GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE, streamer);
+    textures[BLUE_METAL_SPEC] = TextureManager("../resources/textures/blue_metal_plate_rough_1k.png", GL_TEXTURE_2D, GL_TEXTURE1, GL_RGBA, GL_UNSIGNED_BYTE, streamer);
     
-    //awsome face:
-    textures[AWESOME_FACE] = TextureManager("../resources/textures/awesomeface.png", GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE);
-    textures[AWESOME_FACE_SPEC] = TextureManager("../resources/textures/awesomeface.png", GL_TEXTURE_2D, GL_TEXTURE1, GL_RGBA, GL_UNSIGNED_BYTE);
+    //awsome face (one image for both maps, TextureCache loads it once):
+    textures[AWESOME_FACE] = TextureManager("../resources/textures/awesomeface.png", GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE, streamer);
+    textures[AWESOME_FACE_SPEC] = TextureManager("../resources/textures/awesomeface.png", GL_TEXTURE_2D, GL_TEXTURE1, GL_RGBA, GL_UNSIGNED_BYTE, streamer);
     
     //Transparncy window:
-    textures[AWESOME_FACE] = TextureManager("../resources/textures/window.png", GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE);
-    textures[AWESOME_FACE_SPEC] = TextureManager("../resources/textures/window.png", GL_TEXTURE_2D, GL_TEXTURE1, GL_RGBA, GL_UNSIGNED_BYTE);
+    textures[TRANS_WINDOW] = TextureManager("../resources/textures/window.png", GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE, streamer);
+    textures[TRANS_WINDOW_SPEC] = TextureManager("../resources/textures/window.png", GL_TEXTURE_2D, GL_TEXTURE1, GL_RGBA, GL_UNSIGNED_BYTE, streamer);
     
     //ROBOT
-    textures[ROBOT] = TextureManager("../resources/textures/diffuse.png", GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE);
-    textures[ROBOT_SPEC] = TextureManager("../resources/textures/specular.png", GL_TEXTURE_2D, GL_TEXTURE1, GL_RGBA, GL_UNSIGNED_BYTE);
+    textures[ROBOT] = TextureManager("../resources/textures/diffuse.png", GL_TEXTURE_2D, GL_TEXTURE0, GL_RGBA, GL_UNSIGNED_BYTE, streamer);
+    textures[ROBOT_SPEC] = TextureManager("../resources/textures/specular.png", GL_TEXTURE_2D, GL_TEXTURE1, GL_RGBA, GL_UNSIGNED_BYTE, streamer);
     
 }
\ No newline at end of file
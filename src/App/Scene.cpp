@@ -1,53 +1,108 @@
 #include "App/Scene.h"
+#include <cfloat>
+#include <memory>
+#include <optional>
 
 using namespace glm;
 
-Scene::Scene()
+Scene::Scene(UploadThread* uploads) : staticVersion(0), instanceVersion(0), initialStreaming(true)
 {
+    textureStreamer.setUploadThread(uploads);
+    loading.setUploadThread(uploads);
     const glm::mat4 MODEL(1.0f);
     const glm::vec3 X(1.0f, 0.0f, 0.0f), Y(0.0f, 1.0f, 0.0f), Z(0.0f, 0.0f, 1.0f);
+    //geometry and imports on the workers, big buffers on the upload thread, the rest on the GL thread:
 
     //wall:
-    cubes[WALL] = Cubesphere(30.0f, 1, false); 
-    mat4 model = translate(MODEL, glm::vec3(0.0f, 0.0f, -8.0f));
-    model = rotate(model, radians(90.0f), Y);
-    model = scale(model, vec3(0.01f, 1.0f, 1.0f));
-    models[WALL].push_back(model);
-    for(int i=0; i<100; i++){
-        model = translate(model, vec3(300.0f, 0.0f, 0.0f));
-        models[WALL].push_back(model);
-    } 
-    cubeBuffers(WALL);
+    auto wall = std::make_shared<std::optional<Cubesphere>>();
+    auto wallModels = std::make_shared<vector<mat4>>();
+    loading.add(WALL, [=] {
+        wall->emplace(30.0f, 1, false);
+        mat4 model = translate(MODEL, glm::vec3(0.0f, 0.0f, -8.0f));
+        model = rotate(model, radians(90.0f), Y);
+        model = scale(model, vec3(0.01f, 1.0f, 1.0f));
+        wallModels->push_back(model);
+        for(int i=0; i<100; i++){
+            model = translate(model, vec3(300.0f, 0.0f, 0.0f));
+            wallModels->push_back(model);
+        }
+    }, [=] {
+        models[WALL] = std::move(*wallModels);
+        primitiveBuffers(WALL, **wall);
+        //the registry has its own copy:
+        wall->reset();
+    });
+
+    //spheres (the renderer picks a resolution level per instance):
+    auto sphereLods = std::make_shared<vector<Sphere>>();
+    auto sphereModels = std::make_shared<vector<mat4>>();
+    loading.add(SPHERES, [=] {
+        *sphereLods = Sphere::buildLods(1.0f, 64, 32);
+        //a row next to the transformers, from close by to far away:
+        for(int i=0; i<100; i++)
+            sphereModels->push_back(translate(MODEL, vec3(3.0f * i, 1.0f, -4.0f)));
+    }, [=] {
+        models[SPHERES] = std::move(*sphereModels);
+        lodBuffers(SPHERES, *sphereLods);
+        //the registry has its own copy:
+        sphereLods->clear();
+    });
 
     //TRANSFORMER:
-    stbi_set_flip_vertically_on_load(true);
-    threeDModels[TRANSFORMER] = Model("../resources/objects/transformers-one-orion-pax/source/scene.gltf");
-    model = translate(MODEL, glm::vec3(0.0f, 0.0f, -8.0f));
-    model = rotate(model, radians(180.0f), Y);
-    models[TRANSFORMER].push_back(model);
-    for(int i=0; i<100; i++){
-        model = translate(model, vec3(3.0f, 0.0f, 0.0f));
-        models[TRANSFORMER].push_back(model);
-        model = translate(model, vec3(0.0f, 0.0f, 3.0f));
-        models[TRANSFORMER].push_back(model);
-        
-    }
-    threeDmodelBuffers(TRANSFORMER);
+    auto transformer = std::make_shared<Model>();
+    auto transformerModels = std::make_shared<vector<mat4>>();
+    loading.add(TRANSFORMER, [=] {
+        transformer->import("../resources/objects/transformers-one-orion-pax/source/scene.gltf");
+        mat4 model = translate(MODEL, glm::vec3(0.0f, 0.0f, -8.0f));
+        model = rotate(model, radians(180.0f), Y);
+        transformerModels->push_back(model);
+        for(int i=0; i<100; i++){
+            model = translate(model, vec3(3.0f, 0.0f, 0.0f));
+            transformerModels->push_back(model);
+            model = translate(model, vec3(0.0f, 0.0f, 3.0f));
+            transformerModels->push_back(model);
+        }
+    }, [=] {
+        transformer->uploadBuffers();
+    }, [=] {
+        threeDModels[TRANSFORMER] = std::move(*transformer);
+        threeDModels[TRANSFORMER].upload(&textureArrays, &textureStreamer);
+        models[TRANSFORMER] = std::move(*transformerModels);
+        threeDmodelBuffers(TRANSFORMER);
+        shadowBuffers(TRANSFORMER);
+        staticVersion++;
+    });
 
+    //materials, once every model is loaded (the images stream in afterwards):
+    loading.add(MATERIALS, nullptr, [this] {
+        textureArrays.build(&textureStreamer);
+        resolveMaterials();
+    }, { TRANSFORMER });
+}
 
+bool Scene::updateStreaming()
+{
+    textureArrays.updateResidency(&textureStreamer);
+    int pending = textureStreamer.pending();
+    textureStreamer.update();
+    // alpha modes are only known once the images are decoded
+    if (textureArrays.takeAlphaChanges()) resolveMaterials();
+    // finer mip levels keep coming and going afterwards (the model textures are only queued with the materials)
+    bool loaded = initialStreaming && loading.done(MATERIALS) && pending > 0 && textureStreamer.pending() == 0;
+    if (loaded) initialStreaming = false;
+    return loaded;
 }
 
-void Scene::cubeBuffers(string name)
+void Scene::resolveMaterials()
 {
-    //..vbo:
-    VBO vbo(cubes[name].getInterleavedVertices(), cubes[name].getInterleavedVertexSize());
-    //..instanceVBO:
-    VBO instanceVBO(models[name], (int)models[name].size());
-    //..vao:
-    vaos[name] = VAO() ; vaos[name].init(vbo, instanceVBO);
-    //..ebo:
-    ebos[name] = EBO(cubes[name].getIndices(), cubes[name].getIndexSize());
-} 
+    materials.clear();
+    for (auto& threeDModel : threeDModels) {
+        threeDModel.second.resolveTextures(textureArrays);
+        for (Mesh& mesh : threeDModel.second.meshes)
+            mesh.materialIndex = materials.add(mesh.material);
+    }
+    materials.upload();
+}
 
 void Scene::threeDmodelBuffers(string name)
 {
@@ -55,9 +110,23 @@ void Scene::threeDmodelBuffers(string name)
     unsigned int buffer;
     glGenBuffers(1, &buffer);
     glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, models[name].size() * sizeof(glm::mat4), models[name].data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, models[name].size() * sizeof(glm::mat4), models[name].data(), GL_DYNAMIC_DRAW);
+    instanceBuffers[name] = buffer;
+    instanceVersion++;
+    meshRadii[name].clear();
+    glm::vec3 modelLow(FLT_MAX), modelHigh(-FLT_MAX);
     for (unsigned int i = 0; i < threeDModels[name].meshes.size(); i++)
     {
+        //..bounds (half the box diagonal):
+        glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+        for (const Vertex& vertex : threeDModels[name].meshes[i].vertices) {
+            low = glm::min(low, vertex.Position);
+            high = glm::max(high, vertex.Position);
+        }
+        meshRadii[name].push_back(threeDModels[name].meshes[i].vertices.empty() ? 0.0f : 0.5f * glm::length(high - low));
+        modelLow = glm::min(modelLow, low);
+        modelHigh = glm::max(modelHigh, high);
+
         unsigned int VAO = threeDModels[name].meshes[i].VAO;
         glBindVertexArray(VAO);
         // set attribute pointers for matrix (4 times vec4)
@@ -77,4 +146,77 @@ void Scene::threeDmodelBuffers(string name)
 
         glBindVertexArray(0);
     }
-} 
\ No newline at end of file
+    modelBounds[name] = modelLow.x <= modelHigh.x ? glm::vec4(0.5f * (modelLow + modelHigh), 0.5f * glm::length(modelHigh - modelLow)) : glm::vec4(0.0f);
+}
+
+void Scene::setInstances(string name, const vector<glm::mat4>& matrices)
+{
+    if (matrices.size() > models[name].size()) {
+        std::cout << "ERROR::SCENE:: more instances than " << name << " was loaded with" << std::endl;
+        return;
+    }
+    models[name] = matrices;
+    //3D models and LOD meshes upload their instances per frame, shadow casters keep all of them:
+    if (shadowInstanceBuffers.count(name)) {
+        glBindBuffer(GL_ARRAY_BUFFER, shadowInstanceBuffers[name]);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, matrices.size() * sizeof(glm::mat4), matrices.data());
+    }
+    instanceVersion++;
+    if (!dynamicModels.count(name)) staticVersion++;
+}
+
+void Scene::setInstanceOffset(const string& name, GLsizei firstInstance)
+{
+    if (instanceOffsets[name] == firstInstance) return;
+    instanceOffsets[name] = firstInstance;
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffers[name]);
+    for (Mesh& mesh : threeDModels[name].meshes)
+    {
+        glBindVertexArray(mesh.VAO);
+        for (int i = 0; i < 4; i++)
+            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(firstInstance * sizeof(glm::mat4) + i * sizeof(glm::vec4)));
+    }
+    glBindVertexArray(0);
+}
+
+void Scene::impostorBuffers(string name, Shader& bakeShader)
+{
+    impostors[name] = Impostor(threeDModels[name], bakeShader, (int)models[name].size());
+}
+
+void Scene::shadowBuffers(string name)
+{
+    //..instanceVBO (always every instance, the drawing one is culled per frame):
+    unsigned int buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, models[name].size() * sizeof(glm::mat4), models[name].data(), GL_STATIC_DRAW);
+    shadowInstanceBuffers[name] = buffer;
+
+    //..position only stream per mesh:
+    vector<glm::vec3> positions;
+    for (Mesh& mesh : threeDModels[name].meshes)
+    {
+        ShadowCaster caster;
+        positions.clear();
+        for (Vertex& vertex : mesh.vertices) positions.push_back(vertex.Position);
+        glGenVertexArrays(1, &caster.VAO);
+        glGenBuffers(1, &caster.positionVBO);
+        glBindVertexArray(caster.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, caster.positionVBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            glEnableVertexAttribArray(3 + i);
+            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+            glVertexAttribDivisor(3 + i, 1);
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.getEBO());
+        glBindVertexArray(0);
+        caster.indexCount = (GLsizei)mesh.indices.size();
+        shadowCasters[name].push_back(caster);
+    }
+}
@@ -0,0 +1,211 @@
+#include "BlockCompression.h"
+#include "KTX2.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+static uint16_t packRGB565(const float color[3])
+{
+    int r = std::min(31, std::max(0, (int)std::lround(color[0] * 31.0f / 255.0f)));
+    int g = std::min(63, std::max(0, (int)std::lround(color[1] * 63.0f / 255.0f)));
+    int b = std::min(31, std::max(0, (int)std::lround(color[2] * 31.0f / 255.0f)));
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpackRGB565(uint16_t packed, int color[3])
+{
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// picks the nearest of the four colours of (c0, c1) for every texel, returns the squared error
+static int chooseBC1Indices(const float colors[16][3], uint16_t c0, uint16_t c1, int indices[16])
+{
+    int palette[4][3];
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+    }
+    int error = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0, bestError = 1 << 30;
+        for (int p = 0; p < 4; p++) {
+            int e = 0;
+            for (int c = 0; c < 3; c++) {
+                int d = (int)colors[i][c] - palette[p][c];
+                e += d * d;
+            }
+            if (e < bestError) { bestError = e; best = p; }
+        }
+        indices[i] = best;
+        error += bestError;
+    }
+    return error;
+}
+
+void encodeBC1(const unsigned char* rgba, unsigned char* block)
+{
+    float colors[16][3], mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++) {
+            colors[i][c] = rgba[i * 4 + c];
+            mean[c] += colors[i][c] / 16.0f;
+        }
+
+    // principal axis of the colours (power iteration on the covariance)
+    float covariance[3][3] = {};
+    for (int i = 0; i < 16; i++)
+        for (int a = 0; a < 3; a++)
+            for (int b = 0; b < 3; b++)
+                covariance[a][b] += (colors[i][a] - mean[a]) * (colors[i][b] - mean[b]);
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[3];
+        for (int a = 0; a < 3; a++)
+            next[a] = covariance[a][0] * axis[0] + covariance[a][1] * axis[1] + covariance[a][2] * axis[2];
+        float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f) break;
+        for (int a = 0; a < 3; a++) axis[a] = next[a] / length;
+    }
+    float minT = 0.0f, maxT = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < 3; c++) t += (colors[i][c] - mean[c]) * axis[c];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    float end0[3], end1[3];
+    for (int c = 0; c < 3; c++) {
+        end0[c] = mean[c] + axis[c] * maxT;
+        end1[c] = mean[c] + axis[c] * minT;
+    }
+
+    uint16_t bestC0 = packRGB565(end0), bestC1 = packRGB565(end1);
+    int bestIndices[16];
+    int bestError = chooseBC1Indices(colors, bestC0, bestC1, bestIndices);
+
+    // least squares endpoints for the chosen indices (weight of endpoint 0 per index)
+    static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    for (int iteration = 0; iteration < 2 && bestError > 0; iteration++) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = {}, bx[3] = {};
+        for (int i = 0; i < 16; i++) {
+            float a = weights[bestIndices[i]], b = 1.0f - a;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < 3; c++) {
+                ax[c] += a * colors[i][c];
+                bx[c] += b * colors[i][c];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f) break;
+        for (int c = 0; c < 3; c++) {
+            end0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+            end1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+        }
+        uint16_t c0 = packRGB565(end0), c1 = packRGB565(end1);
+        int indices[16];
+        int error = chooseBC1Indices(colors, c0, c1, indices);
+        if (error >= bestError) break;
+        bestError = error;
+        bestC0 = c0;
+        bestC1 = c1;
+        std::memcpy(bestIndices, indices, sizeof(indices));
+    }
+
+    // c0 > c1 selects the four colour mode, swapping the endpoints swaps 0/1 and 2/3
+    if (bestC0 < bestC1) {
+        std::swap(bestC0, bestC1);
+        for (int i = 0; i < 16; i++) bestIndices[i] ^= 1;
+    } else if (bestC0 == bestC1) {
+        for (int i = 0; i < 16; i++) bestIndices[i] = 0;
+    }
+    uint32_t packed = 0;
+    for (int i = 0; i < 16; i++) packed |= (uint32_t)bestIndices[i] << (2 * i);
+    block[0] = (unsigned char)(bestC0 & 0xFF);
+    block[1] = (unsigned char)(bestC0 >> 8);
+    block[2] = (unsigned char)(bestC1 & 0xFF);
+    block[3] = (unsigned char)(bestC1 >> 8);
+    for (int b = 0; b < 4; b++) block[4 + b] = (unsigned char)(packed >> (8 * b));
+}
+
+void encodeBC4(const unsigned char* rgba, int channel, unsigned char* block)
+{
+    int minValue = 255, maxValue = 0;
+    for (int i = 0; i < 16; i++) {
+        minValue = std::min(minValue, (int)rgba[i * 4 + channel]);
+        maxValue = std::max(maxValue, (int)rgba[i * 4 + channel]);
+    }
+    std::memset(block, 0, 8);
+    block[0] = (unsigned char)maxValue;
+    block[1] = (unsigned char)minValue;
+    // constant block: every index 0 reads endpoint 0
+    if (maxValue == minValue) return;
+
+    // endpoint 0 > endpoint 1: eight values, six of them interpolated
+    int palette[8] = { maxValue, minValue };
+    for (int p = 1; p < 7; p++)
+        palette[p + 1] = ((7 - p) * maxValue + p * minValue + 3) / 7;
+    uint64_t packed = 0;
+    for (int i = 0; i < 16; i++) {
+        int value = rgba[i * 4 + channel], best = 0;
+        for (int p = 1; p < 8; p++)
+            if (std::abs(palette[p] - value) < std::abs(palette[best] - value)) best = p;
+        packed |= (uint64_t)best << (3 * i);
+    }
+    for (int b = 0; b < 6; b++) block[2 + b] = (unsigned char)(packed >> (8 * b));
+}
+
+void encodeBC3(const unsigned char* rgba, unsigned char* block)
+{
+    encodeBC4(rgba, 3, block);
+    encodeBC1(rgba, block + 8);
+}
+
+void encodeBC5(const unsigned char* rgba, unsigned char* block)
+{
+    encodeBC4(rgba, 0, block);
+    encodeBC4(rgba, 1, block + 8);
+}
+
+std::vector<unsigned char> compressImage(const unsigned char* rgba, int width, int height, uint32_t vkFormat, int threads)
+{
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4, blockSize = KTX2Texture::blockBytes(vkFormat);
+    std::vector<unsigned char> blocks((size_t)blocksX * blocksY * blockSize);
+    if (blockSize == 0) return blocks;
+
+    auto encodeRows = [&](int firstRow, int step) {
+        unsigned char texels[16 * 4];
+        for (int by = firstRow; by < blocksY; by += step)
+            for (int bx = 0; bx < blocksX; bx++) {
+                for (int y = 0; y < 4; y++)
+                    for (int x = 0; x < 4; x++) {
+                        int sx = std::min(bx * 4 + x, width - 1), sy = std::min(by * 4 + y, height - 1);
+                        std::memcpy(&texels[(y * 4 + x) * 4], &rgba[((size_t)sy * width + sx) * 4], 4);
+                    }
+                unsigned char* block = &blocks[((size_t)by * blocksX + bx) * blockSize];
+                switch (vkFormat) {
+                case KTX2_BC1_RGB:
+                case KTX2_BC1_RGBA: encodeBC1(texels, block); break;
+                case KTX2_BC3: encodeBC3(texels, block); break;
+                case KTX2_BC4: encodeBC4(texels, 0, block); break;
+                case KTX2_BC5: encodeBC5(texels, block); break;
+                }
+            }
+    };
+
+    // interleaved rows keep the threads balanced when the content is not
+    threads = std::max(1, std::min(threads, blocksY));
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++)
+        workers.emplace_back(encodeRows, t, threads);
+    encodeRows(0, threads);
+    for (std::thread& worker : workers) worker.join();
+    return blocks;
+}
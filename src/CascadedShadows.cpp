@@ -0,0 +1,166 @@
+#include "CascadedShadows.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstdio>
+
+// static cascades cover this much more than the fitted sphere so small camera moves stay cached
+static const float STATIC_GUARD = 1.25f;
+// how far behind a cascade casters are still caught (world units along the light)
+static const float CASTER_MARGIN = 100.0f;
+
+static GLuint createShadowArray()
+{
+	GLuint map;
+	glGenTextures(1, &map);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, map);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, CascadedShadows::RESOLUTION, CascadedShadows::RESOLUTION,
+		CascadedShadows::CASCADES, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	float border[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+	// hardware PCF through sampler2DArrayShadow
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return map;
+}
+
+CascadedShadows::CascadedShadows() : cachedLightDirection(0.0f), cachedStaticVersion(0), cacheValid(false)
+{
+	staticMap = createShadowArray();
+	dynamicMap = createShadowArray();
+	glGenFramebuffers(1, &FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	for (int i = 0; i < CASCADES; i++) {
+		staticLightSpace[i] = dynamicLightSpace[i] = glm::mat4(1.0f);
+		staticCenter[i] = glm::vec3(0.0f);
+		staticRadius[i] = staticFitRadius[i] = 0.0f;
+		splits[i] = 0.0f;
+	}
+}
+
+unsigned int CascadedShadows::update(const Camera& camera, float aspect, float zNear, float shadowDistance, glm::vec3 lightDirection, unsigned int staticVersion)
+{
+	unsigned int dirty = 0;
+	lightDirection = glm::normalize(lightDirection);
+	if (!cacheValid || lightDirection != cachedLightDirection || staticVersion != cachedStaticVersion) {
+		cacheValid = false;
+		cachedLightDirection = lightDirection;
+		cachedStaticVersion = staticVersion;
+	}
+
+	// rotation only light view, the cascades translate in light space
+	glm::vec3 up = glm::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+
+	float tanY = std::tan(glm::radians(camera.Zoom) * 0.5f), tanX = tanY * aspect;
+	float sliceNear = zNear;
+	for (int i = 0; i < CASCADES; i++) {
+		// practical split scheme: blend of logarithmic and uniform splits
+		float p = (i + 1) / (float)CASCADES;
+		float logSplit = zNear * std::pow(shadowDistance / zNear, p);
+		float uniformSplit = zNear + (shadowDistance - zNear) * p;
+		float sliceFar = 0.75f * logSplit + 0.25f * uniformSplit;
+		splits[i] = sliceFar;
+
+		// bounding sphere of the slice: its radius does not change when the camera turns
+		glm::vec3 corners[8];
+		int c = 0;
+		for (float d : { sliceNear, sliceFar })
+			for (float sx : { -1.0f, 1.0f })
+				for (float sy : { -1.0f, 1.0f })
+					corners[c++] = camera.Position + camera.Front * d + camera.Right * (sx * d * tanX) + camera.Up * (sy * d * tanY);
+		glm::vec3 center(0.0f);
+		for (glm::vec3& corner : corners) center += corner / 8.0f;
+		float radius = 0.0f;
+		for (glm::vec3& corner : corners) radius = glm::max(radius, glm::length(corner - center));
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+		sliceNear = sliceFar;
+
+		// dynamic cascade: tight fit, center snapped to whole texels
+		glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+		float texel = 2.0f * radius / RESOLUTION;
+		glm::vec3 snapped = glm::vec3(glm::floor(glm::vec2(lightCenter) / texel) * texel, lightCenter.z);
+		dynamicLightSpace[i] = glm::ortho(snapped.x - radius, snapped.x + radius, snapped.y - radius, snapped.y + radius,
+			-snapped.z - radius - CASTER_MARGIN, -snapped.z + radius) * lightView;
+
+		// static cascade: re-fit only when the sphere leaves the guard band
+		glm::vec3 offset = glm::abs(lightCenter - staticCenter[i]);
+		bool scrolled = glm::max(offset.x, glm::max(offset.y, offset.z)) + radius > staticRadius[i];
+		if (!cacheValid || scrolled || radius != staticFitRadius[i]) {
+			float guardRadius = radius * STATIC_GUARD;
+			float guardTexel = 2.0f * guardRadius / RESOLUTION;
+			staticCenter[i] = glm::vec3(glm::floor(glm::vec2(lightCenter) / guardTexel) * guardTexel, lightCenter.z);
+			staticRadius[i] = guardRadius;
+			staticFitRadius[i] = radius;
+			staticLightSpace[i] = glm::ortho(staticCenter[i].x - guardRadius, staticCenter[i].x + guardRadius,
+				staticCenter[i].y - guardRadius, staticCenter[i].y + guardRadius,
+				-staticCenter[i].z - guardRadius - CASTER_MARGIN, -staticCenter[i].z + guardRadius) * lightView;
+			dirty |= 1u << i;
+		}
+	}
+	cacheValid = true;
+	return dirty;
+}
+
+void CascadedShadows::beginLayer(GLuint map, int cascade)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, map, 0, cascade);
+	glViewport(0, 0, RESOLUTION, RESOLUTION);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	// depth only: slope scaled bias against acne
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+}
+
+void CascadedShadows::beginStatic(int cascade)
+{
+	beginLayer(staticMap, cascade);
+}
+
+void CascadedShadows::beginDynamic(int cascade)
+{
+	beginLayer(dynamicMap, cascade);
+}
+
+void CascadedShadows::end(const GLint viewport[4], GLuint sceneFBO)
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void CascadedShadows::bind(Shader& shader)
+{
+	glActiveTexture(GL_TEXTURE0 + STATIC_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, staticMap);
+	glActiveTexture(GL_TEXTURE0 + DYNAMIC_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, dynamicMap);
+	glActiveTexture(GL_TEXTURE0);
+
+	shader.setInt("staticShadowMap", STATIC_UNIT);
+	shader.setInt("dynamicShadowMap", DYNAMIC_UNIT);
+	char name[32];
+	for (int i = 0; i < CASCADES; i++) {
+		snprintf(name, sizeof(name), "staticLightSpace[%d]", i);
+		shader.setMat4(name, staticLightSpace[i]);
+		snprintf(name, sizeof(name), "dynamicLightSpace[%d]", i);
+		shader.setMat4(name, dynamicLightSpace[i]);
+		snprintf(name, sizeof(name), "cascadeSplits[%d]", i);
+		shader.setFloat(name, splits[i]);
+	}
+}
+
+void CascadedShadows::Delete()
+{
+	glDeleteFramebuffers(1, &FBO);
+	glDeleteTextures(1, &staticMap);
+	glDeleteTextures(1, &dynamicMap);
+}
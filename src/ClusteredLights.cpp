@@ -0,0 +1,170 @@
+#include "ClusteredLights.h"
+#include <cmath>
+#include <algorithm>
+#include <initializer_list>
+
+static const int CLUSTER_COUNT = ClusteredLights::GRID_X * ClusteredLights::GRID_Y * ClusteredLights::GRID_Z;
+
+static GLuint createBufferTexture(GLuint buffer, GLenum format)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    return texture;
+}
+
+ClusteredLights::ClusteredLights() : lightCapacity(0), indexCapacity(0), zNear(0.1f), zFar(100.0f)
+{
+    glGenBuffers(1, &lightBuffer);
+    glGenBuffers(1, &rangeBuffer);
+    glGenBuffers(1, &indexBuffer);
+    // texture buffers need storage before they are attached
+    glBindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, rangeBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, CLUSTER_COUNT * 2 * sizeof(GLuint), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(GLuint), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    lightCapacity = sizeof(glm::vec4);
+    indexCapacity = sizeof(GLuint);
+
+    lightTexture = createBufferTexture(lightBuffer, GL_RGBA32F);
+    rangeTexture = createBufferTexture(rangeBuffer, GL_RG32UI);
+    indexTexture = createBufferTexture(indexBuffer, GL_R32UI);
+    ranges.resize(CLUSTER_COUNT * 2);
+}
+
+// exponential slicing: every slice covers the same depth ratio
+int ClusteredLights::slice(float depth) const
+{
+    int z = (int)std::floor(std::log(depth / zNear) / std::log(zFar / zNear) * GRID_Z);
+    return glm::clamp(z, 0, GRID_Z - 1);
+}
+
+void ClusteredLights::update(const std::vector<PointLight>& lights, const glm::mat4& view, float fovY, float aspect, float zNear, float zFar,
+                             FrameAllocator* frameMemory)
+{
+    this->zNear = zNear;
+    this->zFar = zFar;
+    float tanY = std::tan(fovY * 0.5f), tanX = tanY * aspect;
+
+    // 1. cluster range of every light (conservative bounds of its sphere)
+    FrameVector<glm::vec4> lightData(frameMemory);
+    FrameVector<Bounds> lightBounds(frameMemory);
+    lightData.reserve(lights.size() * 4);
+    lightBounds.reserve(lights.size());
+    for (const PointLight& light : lights)
+    {
+        glm::vec3 p = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        float r = light.radius;
+        float dMin = -p.z - r, dMax = -p.z + r;
+        if (dMax < zNear || dMin > zFar) continue;
+        dMin = glm::max(dMin, zNear);
+        dMax = glm::min(dMax, zFar);
+
+        // x/d and y/d are extreme at the corners of the sphere's view space box
+        float xMin = 1e30f, xMax = -1e30f, yMin = 1e30f, yMax = -1e30f;
+        for (float d : { dMin, dMax })
+            for (float s : { -r, r })
+            {
+                xMin = glm::min(xMin, (p.x + s) / (d * tanX)); xMax = glm::max(xMax, (p.x + s) / (d * tanX));
+                yMin = glm::min(yMin, (p.y + s) / (d * tanY)); yMax = glm::max(yMax, (p.y + s) / (d * tanY));
+            }
+        if (xMax < -1.0f || xMin > 1.0f || yMax < -1.0f || yMin > 1.0f) continue;
+
+        Bounds b;
+        b.x0 = glm::clamp((int)std::floor((xMin * 0.5f + 0.5f) * GRID_X), 0, GRID_X - 1);
+        b.x1 = glm::clamp((int)std::floor((xMax * 0.5f + 0.5f) * GRID_X), 0, GRID_X - 1);
+        b.y0 = glm::clamp((int)std::floor((yMin * 0.5f + 0.5f) * GRID_Y), 0, GRID_Y - 1);
+        b.y1 = glm::clamp((int)std::floor((yMax * 0.5f + 0.5f) * GRID_Y), 0, GRID_Y - 1);
+        b.z0 = slice(dMin);
+        b.z1 = slice(dMax);
+        lightBounds.push_back(b);
+
+        // 4 texels per light: position+radius, ambient+constant, diffuse+linear, specular+quadratic
+        lightData.push_back(glm::vec4(light.position, light.radius));
+        lightData.push_back(glm::vec4(light.ambient, light.constant));
+        lightData.push_back(glm::vec4(light.diffuse, light.linear));
+        lightData.push_back(glm::vec4(light.specular, light.quadratic));
+    }
+
+    // 2. count lights per cluster, prefix sum to offsets, then scatter the indices
+    std::fill(ranges.begin(), ranges.end(), 0);
+    for (const Bounds& b : lightBounds)
+        for (int z = b.z0; z <= b.z1; z++)
+            for (int y = b.y0; y <= b.y1; y++)
+                for (int x = b.x0; x <= b.x1; x++)
+                    ranges[((z * GRID_Y + y) * GRID_X + x) * 2 + 1]++;
+    GLuint offset = 0;
+    for (int i = 0; i < CLUSTER_COUNT; i++)
+    {
+        ranges[i * 2] = offset;
+        offset += ranges[i * 2 + 1];
+        ranges[i * 2 + 1] = 0;
+    }
+    FrameVector<GLuint> indices(glm::max(offset, 1u), frameMemory);
+    for (GLuint light = 0; light < (GLuint)lightBounds.size(); light++)
+    {
+        const Bounds& b = lightBounds[light];
+        for (int z = b.z0; z <= b.z1; z++)
+            for (int y = b.y0; y <= b.y1; y++)
+                for (int x = b.x0; x <= b.x1; x++)
+                {
+                    GLuint* range = &ranges[((z * GRID_Y + y) * GRID_X + x) * 2];
+                    indices[range[0] + range[1]++] = light;
+                }
+    }
+
+    // 3. upload
+    if (!lightData.empty())
+        upload(lightBuffer, lightCapacity, lightData.data(), lightData.size() * sizeof(glm::vec4));
+    upload(indexBuffer, indexCapacity, indices.data(), indices.size() * sizeof(GLuint));
+    glBindBuffer(GL_TEXTURE_BUFFER, rangeBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, ranges.size() * sizeof(GLuint), ranges.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+// grows the buffer by doubling, otherwise just overwrites the used part
+void ClusteredLights::upload(GLuint buffer, GLsizeiptr& capacity, const void* data, GLsizeiptr size)
+{
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    if (size > capacity)
+    {
+        while (capacity < size) capacity *= 2;
+        glBufferData(GL_TEXTURE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+    }
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void ClusteredLights::bind(Shader& shader, glm::vec2 screenSize)
+{
+    glActiveTexture(GL_TEXTURE0 + LIGHT_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+    glActiveTexture(GL_TEXTURE0 + RANGE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, rangeTexture);
+    glActiveTexture(GL_TEXTURE0 + INDEX_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader.setInt("lightData", LIGHT_UNIT);
+    shader.setInt("clusterRanges", RANGE_UNIT);
+    shader.setInt("lightIndices", INDEX_UNIT);
+    glUniform3i(glGetUniformLocation(shader.ID, "clusterGrid"), GRID_X, GRID_Y, GRID_Z);
+    shader.setVec2("screenSize", screenSize);
+    shader.setFloat("zNear", zNear);
+    shader.setFloat("zFar", zFar);
+}
+
+void ClusteredLights::Delete()
+{
+    glDeleteTextures(1, &lightTexture);
+    glDeleteTextures(1, &rangeTexture);
+    glDeleteTextures(1, &indexTexture);
+    glDeleteBuffers(1, &lightBuffer);
+    glDeleteBuffers(1, &rangeBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+}
@@ -29,6 +29,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 #include "Cone.h"
 
 
@@ -49,6 +50,33 @@ Cone::Cone(float baseRadius, float height, int sectors, int stacks, bool smooth,
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// build the same cone at decreasing resolutions for LOD selection
+// level 0 is the given resolution, every next level halves sectors and stacks
+///////////////////////////////////////////////////////////////////////////////
+std::vector<Cone> Cone::buildLods(float baseRadius, float height, int sectors, int stacks,
+                                  int levelCount, bool smooth, int up)
+{
+    std::vector<Cone> lods;
+    for(int i = 0; i < levelCount; ++i)
+    {
+        lods.push_back(Cone(baseRadius, height, sectors, stacks, smooth, up));
+        if(sectors <= MIN_SECTOR_COUNT && stacks <= MIN_STACK_COUNT)
+            break;
+        sectors = std::max(sectors / 2, MIN_SECTOR_COUNT);
+        stacks = std::max(stacks / 2, MIN_STACK_COUNT);
+    }
+    return lods;
+}
+
+// radius of the sphere around the centre that contains the whole cone
+float Cone::getBoundingRadius() const
+{
+    return sqrtf(baseRadius * baseRadius + 0.25f * height * height);
+}
+
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // setters
@@ -9,9 +9,13 @@ Controller::Controller(unsigned int width, unsigned int height):
     lastX(width / 2.0f),
     lastY(height / 2.0f),
     firstMouse(true),
+    previousPosition(camera.Position),
+    interpolation(1.0f),
+    nightKeyDown(false),
     SCR_WIDTH(width),
     SCR_HEIGHT(height),
-    isNight(false)
+    isNight(false),
+    windowChanged(true)
 {}
 
 Controller::~Controller() {
@@ -27,13 +31,7 @@ void Controller::initializeOpenGLSettings(){
 
     // configure global opengl state
     glEnable(GL_DEPTH_TEST);
-    // MSAA (Multiple sub-sample anti-analysing)
-    glEnable(GL_MULTISAMPLE); // enabled by default on some drivers, but not all so always enable to make sure
-
-
-    // enable blending:
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // no MSAA or blending on the window: the scene is drawn offscreen (DynamicResolution), the transparency passes blend themselves
 
     //enable face culling:
     glEnable(GL_CULL_FACE);
@@ -52,8 +50,6 @@ bool Controller::initializeWindow(const std::string& title) {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    
-    glfwWindowHint(GLFW_SAMPLES, 4);  // Request 4x MSAA
 
     window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, title.c_str(), nullptr, nullptr);
     if (!window) {
@@ -66,6 +62,7 @@ bool Controller::initializeWindow(const std::string& title) {
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
 
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     glfwSetWindowUserPointer(window, this);
@@ -78,20 +75,47 @@ bool Controller::initializeWindow(const std::string& title) {
     return true;
 }
 
+GLFWwindow* Controller::createUploadContext() {
+    // same context hints as the window, only never shown
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* context = glfwCreateWindow(1, 1, "", nullptr, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (!context)
+        std::cerr << "Failed to create the upload context, uploading on the render thread" << std::endl;
+    return context;
+}
+
 void Controller::processInput() {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 
+    bool nightKey = glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS;
+    if (nightKey && !nightKeyDown)
+        isNight = !isNight;
+    nightKeyDown = nightKey;
+}
+
+bool Controller::isMoving() const {
+    return glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS
+        || glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+}
+
+void Controller::tick(float seconds) {
+    previousPosition = camera.Position;
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        camera.ProcessKeyboard(FORWARD, deltaTime);
+        camera.ProcessKeyboard(FORWARD, seconds);
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        camera.ProcessKeyboard(BACKWARD, deltaTime);
+        camera.ProcessKeyboard(BACKWARD, seconds);
     if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        camera.ProcessKeyboard(LEFT, deltaTime);
+        camera.ProcessKeyboard(LEFT, seconds);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        camera.ProcessKeyboard(RIGHT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS)
-        isNight = !isNight;
+        camera.ProcessKeyboard(RIGHT, seconds);
+}
+
+Camera Controller::getRenderCamera() const {
+    Camera view = camera;
+    view.Position = glm::mix(previousPosition, camera.Position, interpolation);
+    return view;
 }
 
 void Controller::updateDeltaTime() {
@@ -100,8 +124,15 @@ void Controller::updateDeltaTime() {
     lastFrame = currentFrame;
 }
 
-void Controller::framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+void Controller::framebuffer_size_callback(GLFWwindow* window, int, int) {
+    // the context lives on the render thread, the frame input carries the new size there
+    Controller* controller = static_cast<Controller*>(glfwGetWindowUserPointer(window));
+    if (controller) controller->windowChanged = true;
+}
+
+void Controller::window_refresh_callback(GLFWwindow* window) {
+    Controller* controller = static_cast<Controller*>(glfwGetWindowUserPointer(window));
+    if (controller) controller->windowChanged = true;
 }
 
 void Controller::mouse_callback(GLFWwindow* window, double xpos, double ypos) {
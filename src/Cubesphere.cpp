@@ -23,6 +23,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 #include "Cubesphere.h"
 
 
@@ -46,6 +47,25 @@ Cubesphere::Cubesphere(float radius, int sub, bool smooth) : radius(radius), sub
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// build the same cubesphere at decreasing resolutions for LOD selection
+// level 0 is the given resolution, every next level halves the subdivision
+///////////////////////////////////////////////////////////////////////////////
+std::vector<Cubesphere> Cubesphere::buildLods(float radius, int sub, int levelCount, bool smooth)
+{
+    std::vector<Cubesphere> lods;
+    for(int i = 0; i < levelCount; ++i)
+    {
+        lods.push_back(Cubesphere(radius, sub, smooth));
+        if(sub <= 1)
+            break;
+        sub = std::max(sub / 2, 1);
+    }
+    return lods;
+}
+
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // setters
@@ -30,6 +30,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 #include "Cylinder.h"
 
 
@@ -50,6 +51,35 @@ Cylinder::Cylinder(float baseRadius, float topRadius, float height, int sectors,
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// build the same cylinder at decreasing resolutions for LOD selection
+// level 0 is the given resolution, every next level halves sectors and stacks
+// (down to MIN_SECTOR_COUNT / MIN_STACK_COUNT)
+///////////////////////////////////////////////////////////////////////////////
+std::vector<Cylinder> Cylinder::buildLods(float baseRadius, float topRadius, float height,
+                                          int sectors, int stacks, int levelCount, bool smooth, int up)
+{
+    std::vector<Cylinder> lods;
+    for(int i = 0; i < levelCount; ++i)
+    {
+        lods.push_back(Cylinder(baseRadius, topRadius, height, sectors, stacks, smooth, up));
+        if(sectors <= MIN_SECTOR_COUNT && stacks <= MIN_STACK_COUNT)
+            break;
+        sectors = std::max(sectors / 2, MIN_SECTOR_COUNT);
+        stacks = std::max(stacks / 2, MIN_STACK_COUNT);
+    }
+    return lods;
+}
+
+// radius of the sphere around the centre that contains the whole cylinder
+float Cylinder::getBoundingRadius() const
+{
+    float r = baseRadius > topRadius ? baseRadius : topRadius;
+    return sqrtf(r * r + 0.25f * height * height);
+}
+
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // setters
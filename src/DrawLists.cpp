@@ -0,0 +1,79 @@
+#include "DrawLists.h"
+#include "AllocationCounter.h"
+#include <algorithm>
+
+Frustum::Frustum(const glm::mat4& m)
+{
+	// rows of the matrix (glm is column major)
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++) rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+	for (int i = 0; i < 3; i++) {
+		planes[2 * i] = rows[3] + rows[i];
+		planes[2 * i + 1] = rows[3] - rows[i];
+	}
+	for (glm::vec4& plane : planes) plane /= glm::length(glm::vec3(plane));
+}
+
+bool Frustum::intersectsSphere(glm::vec3 center, float radius) const
+{
+	for (const glm::vec4& plane : planes)
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+	return true;
+}
+
+DrawListBuilder::DrawListBuilder(JobSystem* jobSystem, FrameAllocator* frameMemory)
+	: jobSystem(jobSystem), frameMemory(frameMemory), merged(frameMemory), jobAllocations(0) {}
+
+uint32_t DrawListBuilder::sortKey(unsigned int bucket, float depth, float maxDepth)
+{
+	float normalized = glm::clamp(depth / maxDepth, 0.0f, 1.0f);
+	return (uint32_t)bucket << 24 | (uint32_t)(normalized * 16777215.0f);
+}
+
+const FrameVector<DrawItem>& DrawListBuilder::build(size_t count, FunctionRef<void(size_t, size_t, size_t, FrameVector<DrawItem>&)> emit)
+{
+	size_t jobs = jobCount(count);
+	FrameVector<FrameVector<DrawItem>> jobItems(frameMemory);
+	jobItems.reserve(jobs);
+	for (size_t job = 0; job < jobs; job++) jobItems.emplace_back(frameMemory);
+	forEachRange(count, [&](size_t begin, size_t end) {
+		FrameVector<DrawItem>& items = jobItems[begin / GRAIN];
+		// usually one item per instance at most
+		items.reserve(end - begin);
+		emit(begin, end, begin / GRAIN, items);
+		std::sort(items.begin(), items.end());
+	});
+
+	// k-way merge through a min-heap of the jobs' current heads
+	size_t total = 0;
+	for (size_t job = 0; job < jobs; job++) total += jobItems[job].size();
+	// a new list, the last one's memory stays with its frame
+	merged = FrameVector<DrawItem>(frameMemory);
+	merged.reserve(total);
+	FrameVector<size_t> heads(jobs, 0, frameMemory), heap(frameMemory);
+	heap.reserve(jobs);
+	for (size_t job = 0; job < jobs; job++)
+		if (!jobItems[job].empty()) heap.push_back(job);
+	auto later = [&](size_t a, size_t b) { return jobItems[b][heads[b]] < jobItems[a][heads[a]]; };
+	std::make_heap(heap.begin(), heap.end(), later);
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end(), later);
+		size_t job = heap.back();
+		merged.push_back(jobItems[job][heads[job]++]);
+		if (heads[job] < jobItems[job].size()) std::push_heap(heap.begin(), heap.end(), later);
+		else heap.pop_back();
+	}
+	return merged;
+}
+
+void DrawListBuilder::forEachRange(size_t count, FunctionRef<void(size_t, size_t)> body)
+{
+	// a range never waits, so nothing else runs on its thread in between
+	auto counted = [&](size_t begin, size_t end) {
+		size_t before = AllocationCounter::thisThread();
+		body(begin, end);
+		jobAllocations.fetch_add(AllocationCounter::thisThread() - before, std::memory_order_relaxed);
+	};
+	if (jobSystem) jobSystem->parallelFor(count, GRAIN, counted);
+	else for (size_t begin = 0; begin < count; begin += GRAIN) counted(begin, std::min(begin + GRAIN, count));
+}
@@ -0,0 +1,150 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// share of a new measurement in the smoothed time
+static const float TIME_SMOOTHING = 0.2f;
+// the scale only grows while the time stays this far below the target
+static const float HEADROOM = 0.85f;
+// scale steps, so tiny changes don't shift the image every frame
+static const float SCALE_STEP = 1.0f / 64.0f;
+
+DynamicResolution::DynamicResolution() : FBO(0), resolveFBO(0), color(0), depth(0), msaaColorRBO(0), msaaDepthRBO(0),
+	width(0), height(0), samples(1), scale(1.0f), nextQuery(0), targetTime(0.0f), filteredTime(0.0f)
+{
+	for (int i = 0; i < QUERY_LATENCY; i++) {
+		queries[i] = 0;
+		issued[i] = false;
+	}
+}
+
+static GLuint createTarget(GLenum internalFormat, GLenum format, GLenum type, GLenum filter, unsigned int width, unsigned int height)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+DynamicResolution::DynamicResolution(unsigned int width, unsigned int height, float targetMilliseconds, int samples)
+	: msaaColorRBO(0), msaaDepthRBO(0), width(width), height(height), samples(samples), scale(1.0f), nextQuery(0),
+	targetTime(targetMilliseconds), filteredTime(0.0f)
+{
+	color = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_LINEAR, width, height);
+	depth = createTarget(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, GL_NEAREST, width, height);
+	glGenFramebuffers(1, &resolveFBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::DYNAMIC_RESOLUTION:: framebuffer is not complete" << std::endl;
+	FBO = resolveFBO;
+
+	if (samples > 1) {
+		glGenRenderbuffers(1, &msaaColorRBO);
+		glBindRenderbuffer(GL_RENDERBUFFER, msaaColorRBO);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+		glGenRenderbuffers(1, &msaaDepthRBO);
+		glBindRenderbuffer(GL_RENDERBUFFER, msaaDepthRBO);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+		glGenFramebuffers(1, &FBO);
+		glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, msaaColorRBO);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, msaaDepthRBO);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+			std::cout << "ERROR::DYNAMIC_RESOLUTION:: multisampled framebuffer is not complete" << std::endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenQueries(QUERY_LATENCY, queries);
+	for (int i = 0; i < QUERY_LATENCY; i++) issued[i] = false;
+}
+
+void DynamicResolution::begin()
+{
+	// the query issued QUERY_LATENCY frames ago is normally done by now
+	GLuint query = queries[nextQuery];
+	if (issued[nextQuery]) {
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+			adjust((float)(elapsed / 1.0e6));
+		}
+		// a late result is dropped rather than waited for
+	}
+	glBeginQuery(GL_TIME_ELAPSED, query);
+	issued[nextQuery] = true;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glViewport(0, 0, renderWidth(), renderHeight());
+}
+
+void DynamicResolution::end()
+{
+	if (FBO != resolveFBO) {
+		// depth too, the post passes read it; same size, so GL_NEAREST is a plain resolve
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+		glBlitFramebuffer(0, 0, renderWidth(), renderHeight(), 0, 0, renderWidth(), renderHeight(),
+			GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+	}
+	glEndQuery(GL_TIME_ELAPSED);
+	nextQuery = (nextQuery + 1) % QUERY_LATENCY;
+}
+
+void DynamicResolution::adjust(float milliseconds)
+{
+	filteredTime = filteredTime > 0.0f ? filteredTime + (milliseconds - filteredTime) * TIME_SMOOTHING : milliseconds;
+	// the cost goes with the pixel count, the side length with its square root
+	float wanted = scale * std::sqrt(targetTime / std::max(filteredTime, 0.01f));
+	// back off quickly when over the target, come back slowly once there is room
+	if (filteredTime > targetTime) scale += (wanted - scale) * 0.5f;
+	else if (filteredTime < targetTime * HEADROOM) scale += (wanted - scale) * 0.1f;
+	scale = std::min(1.0f, std::max(MIN_SCALE, std::round(scale / SCALE_STEP) * SCALE_STEP));
+}
+
+unsigned int DynamicResolution::renderWidth() const
+{
+	return std::max(1u, (unsigned int)std::lround(width * scale));
+}
+
+unsigned int DynamicResolution::renderHeight() const
+{
+	return std::max(1u, (unsigned int)std::lround(height * scale));
+}
+
+glm::vec2 DynamicResolution::uvScale() const
+{
+	return glm::vec2((float)renderWidth() / width, (float)renderHeight() / height);
+}
+
+void DynamicResolution::bindTexture(GLuint unit)
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, color);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void DynamicResolution::Delete()
+{
+	glDeleteQueries(QUERY_LATENCY, queries);
+	if (FBO != resolveFBO) {
+		glDeleteFramebuffers(1, &FBO);
+		glDeleteRenderbuffers(1, &msaaColorRBO);
+		glDeleteRenderbuffers(1, &msaaDepthRBO);
+	}
+	glDeleteFramebuffers(1, &resolveFBO);
+	glDeleteTextures(1, &color);
+	glDeleteTextures(1, &depth);
+}
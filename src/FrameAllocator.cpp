@@ -0,0 +1,51 @@
+#include "FrameAllocator.h"
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+FrameAllocator::FrameAllocator(size_t capacity) : block(allocateBlock(capacity)), size(capacity), offset(0), overflowBytes(0) {}
+
+FrameAllocator::~FrameAllocator()
+{
+	reset();
+	::operator delete(block, std::align_val_t(BLOCK_ALIGNMENT));
+}
+
+unsigned char* FrameAllocator::allocateBlock(size_t size)
+{
+	return (unsigned char*)::operator new(size, std::align_val_t(BLOCK_ALIGNMENT));
+}
+
+void* FrameAllocator::allocate(size_t bytes, size_t alignment)
+{
+	assert(alignment <= BLOCK_ALIGNMENT && (alignment & (alignment - 1)) == 0);
+	size_t current = offset.load(std::memory_order_relaxed);
+	while (true) {
+		size_t begin = (current + alignment - 1) & ~(alignment - 1);
+		if (begin + bytes > size) break;
+		if (offset.compare_exchange_weak(current, begin + bytes, std::memory_order_relaxed)) return block + begin;
+	}
+
+	// full: the heap for now, the block grows at the next reset
+	void* memory = ::operator new(bytes, std::align_val_t(BLOCK_ALIGNMENT));
+	overflowBytes.fetch_add(bytes + alignment, std::memory_order_relaxed);
+	std::lock_guard<std::mutex> lock(overflowMutex);
+	overflow.push_back(memory);
+	return memory;
+}
+
+void FrameAllocator::reset()
+{
+	for (void* memory : overflow) ::operator delete(memory, std::align_val_t(BLOCK_ALIGNMENT));
+	overflow.clear();
+	size_t needed = size + overflowBytes.load(std::memory_order_relaxed);
+	if (needed > size) {
+		size_t grown = std::max(size, BLOCK_ALIGNMENT);
+		while (grown < needed) grown *= 2;
+		::operator delete(block, std::align_val_t(BLOCK_ALIGNMENT));
+		block = allocateBlock(grown);
+		size = grown;
+	}
+	offset.store(0, std::memory_order_relaxed);
+	overflowBytes.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,53 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <thread>
+
+// below this much time left waitForDeadline() yields instead of sleeping
+static const double SPIN_SECONDS = 0.002;
+
+FrameScheduler::FrameScheduler(double tickRate, double maxFrameRate)
+	: tick(1.0 / tickRate), frameInterval(maxFrameRate > 0.0 ? 1.0 / maxFrameRate : 0.0), accumulator(0.0),
+	lastTime(Clock::now()), deadline(Clock::now())
+{
+}
+
+int FrameScheduler::beginFrame()
+{
+	Clock::time_point now = Clock::now();
+	accumulator += std::chrono::duration<double>(now - lastTime).count();
+	lastTime = now;
+	int ticks = (int)(accumulator / tick);
+	if (ticks > MAX_TICKS_PER_FRAME) {
+		ticks = MAX_TICKS_PER_FRAME;
+		accumulator = tick * ticks;
+	}
+	accumulator -= tick * ticks;
+	return ticks;
+}
+
+float FrameScheduler::alpha() const
+{
+	return (float)std::min(accumulator / tick, 1.0);
+}
+
+void FrameScheduler::waitForDeadline()
+{
+	if (frameInterval <= 0.0) return;
+	deadline += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(frameInterval));
+	Clock::time_point now = Clock::now();
+	// a missed deadline starts a new schedule instead of rushing the next frames
+	if (deadline < now) {
+		deadline = now;
+		return;
+	}
+	std::chrono::duration<double> left = deadline - now;
+	if (left.count() > SPIN_SECONDS)
+		std::this_thread::sleep_for(left - std::chrono::duration<double>(SPIN_SECONDS));
+	while (Clock::now() < deadline) std::this_thread::yield();
+}
+
+void FrameScheduler::reset()
+{
+	accumulator = tick;
+	lastTime = deadline = Clock::now();
+}
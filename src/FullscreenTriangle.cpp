@@ -0,0 +1,19 @@
+#include "FullscreenTriangle.h"
+
+FullscreenTriangle::FullscreenTriangle()
+{
+	// core profile still needs a bound VAO for any draw call
+	glGenVertexArrays(1, &VAO);
+}
+
+void FullscreenTriangle::draw()
+{
+	glBindVertexArray(VAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+}
+
+void FullscreenTriangle::Delete()
+{
+	glDeleteVertexArrays(1, &VAO);
+}
@@ -0,0 +1,66 @@
+#include "GBuffer.h"
+#include <iostream>
+
+static GLuint createTarget(GLenum internalFormat, GLenum format, GLenum type, unsigned int width, unsigned int height)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+GBuffer::GBuffer() : FBO(0), albedoSpec(0), normal(0), depth(0), width(0), height(0) {}
+
+GBuffer::GBuffer(unsigned int width, unsigned int height) : width(width), height(height)
+{
+	albedoSpec = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+	normal = createTarget(GL_RGB16F, GL_RGB, GL_FLOAT, width, height);
+	depth = createTarget(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, width, height);
+
+	glGenFramebuffers(1, &FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoSpec, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normal, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+	unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, attachments);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::GBUFFER:: framebuffer is not complete" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GBuffer::Bind(unsigned int viewWidth, unsigned int viewHeight)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glViewport(0, 0, viewWidth, viewHeight);
+}
+
+void GBuffer::Unbind(GLuint sceneFBO)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+}
+
+void GBuffer::bindTextures(GLuint firstUnit)
+{
+	glActiveTexture(GL_TEXTURE0 + firstUnit);
+	glBindTexture(GL_TEXTURE_2D, albedoSpec);
+	glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+	glBindTexture(GL_TEXTURE_2D, normal);
+	glActiveTexture(GL_TEXTURE0 + firstUnit + 2);
+	glBindTexture(GL_TEXTURE_2D, depth);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void GBuffer::Delete()
+{
+	glDeleteFramebuffers(1, &FBO);
+	glDeleteTextures(1, &albedoSpec);
+	glDeleteTextures(1, &normal);
+	glDeleteTextures(1, &depth);
+}
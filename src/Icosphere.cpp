@@ -23,6 +23,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 #include "Icosphere.h"
 
 
@@ -44,6 +45,25 @@ Icosphere::Icosphere(float radius, int sub, bool smooth) : radius(radius), subdi
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// build the same icosphere at decreasing resolutions for LOD selection
+// level 0 is the given resolution, every next level halves the subdivision
+///////////////////////////////////////////////////////////////////////////////
+std::vector<Icosphere> Icosphere::buildLods(float radius, int sub, int levelCount, bool smooth)
+{
+    std::vector<Icosphere> lods;
+    for(int i = 0; i < levelCount; ++i)
+    {
+        lods.push_back(Icosphere(radius, sub, smooth));
+        if(sub <= 1)
+            break;
+        sub = std::max(sub / 2, 1);
+    }
+    return lods;
+}
+
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // setters
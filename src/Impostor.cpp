@@ -0,0 +1,176 @@
+#include "Impostor.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+
+// quad corners, expanded to a billboard in the vertex shader
+static const float quadVertices[] = {
+    -1.0f, -1.0f,
+     1.0f, -1.0f,
+     1.0f,  1.0f,
+    -1.0f,  1.0f
+};
+
+// octahedral mapping of the [0,1]^2 atlas to directions on the unit sphere (+Y up)
+static glm::vec3 octahedronDecode(glm::vec2 uv)
+{
+    glm::vec2 f = uv * 2.0f - 1.0f;
+    glm::vec3 n(f.x, 1.0f - glm::abs(f.x) - glm::abs(f.y), f.y);
+    float t = glm::max(-n.y, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.z += n.z >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+Impostor::Impostor() : quadVAO(0), quadVBO(0), instanceVBO(0), maxInstances(0),
+    colorAtlas(0), normalDepthAtlas(0), framesPerSide(0), frameResolution(0), center(0.0f), radius(0.0f) {}
+
+Impostor::Impostor(Model& model, Shader& bakeShader, int maxInstances, int framesPerSide, int frameResolution) :
+    maxInstances(maxInstances), framesPerSide(framesPerSide), frameResolution(frameResolution)
+{
+    // bounding sphere of all meshes:
+    glm::vec3 minPos(1e30f), maxPos(-1e30f);
+    for (Mesh& mesh : model.meshes)
+        for (Vertex& vertex : mesh.vertices) {
+            minPos = glm::min(minPos, vertex.Position);
+            maxPos = glm::max(maxPos, vertex.Position);
+        }
+    center = (minPos + maxPos) * 0.5f;
+    radius = 0.0f;
+    for (Mesh& mesh : model.meshes)
+        for (Vertex& vertex : mesh.vertices)
+            radius = glm::max(radius, glm::length(vertex.Position - center));
+
+    bake(model, bakeShader);
+
+    // billboard quad + per instance model matrices (locations 3-6 as in the main shader)
+    glGenVertexArrays(1, &quadVAO);
+    glGenBuffers(1, &quadVBO);
+    glGenBuffers(1, &instanceVBO);
+    glBindVertexArray(quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, maxInstances * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    for (unsigned int i = 0; i < 4; i++) {
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+        glVertexAttribDivisor(3 + i, 1);
+    }
+    glBindVertexArray(0);
+}
+
+void Impostor::bake(Model& model, Shader& bakeShader)
+{
+    int atlasSize = framesPerSide * frameResolution;
+
+    glGenTextures(1, &colorAtlas);
+    glBindTexture(GL_TEXTURE_2D, colorAtlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasSize, atlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // xyz: model space normal, w: depth inside the bounding sphere (0.5 = center plane)
+    glGenTextures(1, &normalDepthAtlas);
+    glBindTexture(GL_TEXTURE_2D, normalDepthAtlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, atlasSize, atlasSize, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    unsigned int fbo, depthRBO;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorAtlas, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalDepthAtlas, 0);
+    glGenRenderbuffers(1, &depthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlasSize, atlasSize);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, attachments);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::IMPOSTOR:: bake framebuffer is not complete" << std::endl;
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_BLEND);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    bakeShader.use();
+    bakeShader.setInt("texture_diffuse1", 0);
+    glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius);
+    bakeShader.setMat4("projection", projection);
+    for (int y = 0; y < framesPerSide; y++)
+        for (int x = 0; x < framesPerSide; x++) {
+            // frame centers sit on the grid vertices so neighbours can be blended
+            glm::vec3 dir = octahedronDecode(glm::vec2(x, y) / (float)(framesPerSide - 1));
+            glm::vec3 up = glm::abs(dir.y) > 0.999f ? glm::vec3(0.0f, 0.0f, -1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            glm::mat4 view = glm::lookAt(center + dir * 2.0f * radius, center, up);
+            bakeShader.setMat4("view", view);
+            glViewport(x * frameResolution, y * frameResolution, frameResolution, frameResolution);
+            for (Mesh& mesh : model.meshes) {
+                mesh.bindMaterial();
+                glBindVertexArray(mesh.VAO);
+                glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(mesh.indices.size()), GL_UNSIGNED_INT, 0);
+            }
+        }
+    glBindVertexArray(0);
+    glVertexAttribI1i(MATERIAL_LOCATION, 0);
+
+    glBindTexture(GL_TEXTURE_2D, colorAtlas);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &depthRBO);
+    glDeleteFramebuffers(1, &fbo);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    if (blend) glEnable(GL_BLEND);
+}
+
+void Impostor::rebake(Model& model, Shader& bakeShader)
+{
+    glDeleteTextures(1, &colorAtlas);
+    glDeleteTextures(1, &normalDepthAtlas);
+    bake(model, bakeShader);
+}
+
+void Impostor::draw(Shader& shader, const std::vector<glm::mat4>& instances, const glm::vec2& fade)
+{
+    if (instances.empty()) return;
+    GLsizei count = (GLsizei)glm::min((int)instances.size(), maxInstances);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::mat4), instances.data());
+
+    shader.use();
+    shader.setInt("colorAtlas", 0);
+    shader.setInt("normalDepthAtlas", 1);
+    shader.setInt("framesPerSide", framesPerSide);
+    shader.setVec3("impostorCenter", center);
+    shader.setFloat("impostorRadius", radius);
+    shader.setVec2("lodFade", fade);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, colorAtlas);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, normalDepthAtlas);
+
+    glBindVertexArray(quadVAO);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, count);
+    glBindVertexArray(0);
+}
+
+void Impostor::Delete()
+{
+    glDeleteVertexArrays(1, &quadVAO);
+    glDeleteBuffers(1, &quadVBO);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteTextures(1, &colorAtlas);
+    glDeleteTextures(1, &normalDepthAtlas);
+}
@@ -0,0 +1,301 @@
+#include "JobSystem.h"
+
+struct Job
+{
+	std::function<void()> work;
+	// parallelFor() chunks run (*range)(begin, end) instead
+	const FunctionRef<void(size_t, size_t)>* range;
+	size_t begin, end;
+	JobCounter* counter;
+	JobPriority priority;
+	// the queue (injected, free) the job is in
+	Job* next;
+};
+
+// the job system and worker index of the calling thread (-1: not a worker)
+static thread_local JobSystem* currentSystem = nullptr;
+static thread_local int currentWorker = -1;
+
+JobSystem::WorkDeque::WorkDeque() : top(0), bottom(0), slots(new std::atomic<Job*>[DEQUE_CAPACITY])
+{
+	for (int i = 0; i < DEQUE_CAPACITY; i++) slots[i].store(nullptr, std::memory_order_relaxed);
+}
+
+bool JobSystem::WorkDeque::push(Job* job)
+{
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+	if (b - t >= DEQUE_CAPACITY) return false;
+	slots[b % DEQUE_CAPACITY].store(job, std::memory_order_release);
+	bottom.store(b + 1, std::memory_order_release);
+	return true;
+}
+
+Job* JobSystem::WorkDeque::pop()
+{
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_relaxed);
+	if (t > b) {
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	Job* job = slots[b % DEQUE_CAPACITY].load(std::memory_order_relaxed);
+	if (t == b) {
+		// the last one, a thief may be after it too
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobSystem::WorkDeque::steal()
+{
+	int64_t t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_acquire);
+	if (t >= b) return nullptr;
+	Job* job = slots[t % DEQUE_CAPACITY].load(std::memory_order_acquire);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+	return job;
+}
+
+void JobSystem::JobQueue::push(Job* job)
+{
+	job->next = nullptr;
+	if (tail) tail->next = job;
+	else head = job;
+	tail = job;
+}
+
+Job* JobSystem::JobQueue::pop()
+{
+	Job* job = head;
+	if (job) {
+		head = job->next;
+		if (!head) tail = nullptr;
+	}
+	return job;
+}
+
+JobSystem::JobSystem(unsigned int threads) : queued(0), sleeping(0), stopping(false)
+{
+	threads = std::max(1u, threads);
+	for (int i = 0; i < INITIAL_JOBS; i++) freeJobs.push(new Job());
+	for (unsigned int i = 0; i < threads; i++) workers.emplace_back(new Worker());
+	for (unsigned int i = 0; i < threads; i++)
+		workers[i]->thread = std::thread(&JobSystem::work, this, (int)i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers) worker->thread.join();
+	while (Job* job = freeJobs.pop()) delete job;
+}
+
+JobSystem& JobSystem::shared()
+{
+	static JobSystem system;
+	return system;
+}
+
+Job* JobSystem::createJob(JobCounter* counter, JobPriority priority)
+{
+	if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+	Job* job;
+	{
+		std::lock_guard<std::mutex> lock(freeMutex);
+		job = freeJobs.pop();
+	}
+	if (!job) job = new Job();
+	job->range = nullptr;
+	job->counter = counter;
+	job->priority = priority;
+	return job;
+}
+
+void JobSystem::run(std::function<void()> work, JobCounter* counter, JobPriority priority)
+{
+	Job* job = createJob(counter, priority);
+	job->work = std::move(work);
+	schedule(job);
+}
+
+void JobSystem::runAfter(JobCounter& dependency, std::function<void()> work, JobCounter* counter, JobPriority priority)
+{
+	Job* job = createJob(counter, priority);
+	job->work = std::move(work);
+	{
+		std::lock_guard<std::mutex> lock(dependency.mutex);
+		if (dependency.pending.load(std::memory_order_acquire) > 0) {
+			dependency.continuations.push_back(job);
+			return;
+		}
+	}
+	schedule(job);
+}
+
+void JobSystem::schedule(Job* job)
+{
+	int priority = (int)job->priority;
+	if (!(currentSystem == this && currentWorker >= 0 && workers[currentWorker]->deques[priority].push(job))) {
+		std::lock_guard<std::mutex> lock(injectedMutex);
+		injected[priority].push(job);
+	}
+	queued.fetch_add(1, std::memory_order_seq_cst);
+	// the lock orders this against a worker going to sleep
+	if (sleeping.load(std::memory_order_seq_cst) > 0) {
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wake.notify_one();
+	}
+}
+
+Job* JobSystem::find(int worker, JobPriority lowest)
+{
+	for (int priority = 0; priority <= (int)lowest; priority++) {
+		Job* job = nullptr;
+		if (worker >= 0) job = workers[worker]->deques[priority].pop();
+		if (!job) {
+			std::lock_guard<std::mutex> lock(injectedMutex);
+			job = injected[priority].pop();
+		}
+		// steal, starting after ourselves so thieves spread out
+		for (size_t i = 1; !job && i <= workers.size(); i++) {
+			size_t victim = (size_t)(worker + (int)i) % workers.size();
+			if ((int)victim != worker) job = workers[victim]->deques[priority].steal();
+		}
+		if (job) {
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::execute(Job* job)
+{
+	if (job->range) (*job->range)(job->begin, job->end);
+	else job->work();
+	JobCounter* counter = job->counter;
+	// whatever the work held goes now, not when the job is reused
+	job->work = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(freeMutex);
+		freeJobs.push(job);
+	}
+	if (counter) finish(counter);
+}
+
+void JobSystem::finish(JobCounter* counter)
+{
+	std::vector<Job*> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+		ready.swap(counter->continuations);
+	}
+	// the counter may be gone from here on (its waiter returned)
+	for (Job* job : ready) schedule(job);
+}
+
+void JobSystem::hold(JobCounter& counter)
+{
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+}
+
+void JobSystem::release(JobCounter& counter)
+{
+	finish(&counter);
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+	bool glThread = std::this_thread::get_id() == this->glThread;
+	int worker = currentSystem == this ? currentWorker : -1;
+	while (!counter.done()) {
+		if (glThread) runGLJobs();
+		Job* job = find(worker, JobPriority::Frame);
+		if (job) execute(job);
+		else std::this_thread::yield();
+	}
+	// the last finish() may still be leaving the counter's lock
+	std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, FunctionRef<void(size_t, size_t)> body, JobPriority priority)
+{
+	if (count == 0) return;
+	grain = std::max<size_t>(grain, 1);
+	// one chunk: not worth a job
+	if (count <= grain) {
+		for (size_t begin = 0; begin < count; begin += grain) body(begin, std::min(begin + grain, count));
+		return;
+	}
+	JobCounter counter;
+	for (size_t begin = grain; begin < count; begin += grain) {
+		Job* job = createJob(&counter, priority);
+		job->range = &body;
+		job->begin = begin;
+		job->end = std::min(begin + grain, count);
+		schedule(job);
+	}
+	// the first chunk right here, the rest as they come
+	body(0, grain);
+	wait(counter);
+}
+
+void JobSystem::setGLThread()
+{
+	glThread = std::this_thread::get_id();
+}
+
+void JobSystem::setGLWake(std::function<void()> wake)
+{
+	std::lock_guard<std::mutex> lock(glMutex);
+	glWake = std::move(wake);
+}
+
+void JobSystem::runOnGLThread(std::function<void()> work, JobCounter* counter)
+{
+	Job* job = createJob(counter, JobPriority::Frame);
+	job->work = std::move(work);
+	std::lock_guard<std::mutex> lock(glMutex);
+	glJobs.push_back(job);
+	// under the lock, so it can't be cleared while it runs
+	if (glWake) glWake();
+}
+
+void JobSystem::runGLJobs()
+{
+	std::vector<Job*> jobs;
+	{
+		std::lock_guard<std::mutex> lock(glMutex);
+		jobs.swap(glJobs);
+	}
+	for (Job* job : jobs) execute(job);
+}
+
+void JobSystem::work(int worker)
+{
+	currentSystem = this;
+	currentWorker = worker;
+	while (true) {
+		Job* job = find(worker, JobPriority::Background);
+		if (job) {
+			execute(job);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleeping.fetch_add(1, std::memory_order_seq_cst);
+		wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_seq_cst) > 0; });
+		sleeping.fetch_sub(1, std::memory_order_seq_cst);
+		// queued jobs still run before the workers stop
+		if (stopping && queued.load(std::memory_order_seq_cst) == 0) return;
+	}
+}
@@ -0,0 +1,275 @@
+#include "KTX2.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// «KTX 20»\r\n\x1A\n
+static const unsigned char IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+// identifier + 9 header words + index (4 words, 2 quad words)
+static const size_t HEADER_BYTES = 80;
+// byteOffset, byteLength, uncompressedByteLength
+static const size_t LEVEL_INDEX_BYTES = 24;
+
+// the files are little endian, like every platform this project builds for
+static uint32_t readWord(const unsigned char* bytes)
+{
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint64_t readQuadWord(const unsigned char* bytes)
+{
+    uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static void writeWord(std::vector<unsigned char>& bytes, uint32_t value)
+{
+    const unsigned char* raw = reinterpret_cast<const unsigned char*>(&value);
+    bytes.insert(bytes.end(), raw, raw + sizeof(value));
+}
+
+static void writeQuadWord(std::vector<unsigned char>& bytes, uint64_t value)
+{
+    const unsigned char* raw = reinterpret_cast<const unsigned char*>(&value);
+    bytes.insert(bytes.end(), raw, raw + sizeof(value));
+}
+
+static void pad(std::vector<unsigned char>& bytes, size_t alignment)
+{
+    while (bytes.size() % alignment) bytes.push_back(0);
+}
+
+// basic data format descriptor (Khronos Data Format 1.3) of a 4x4 block format
+static void writeDataFormatDescriptor(std::vector<unsigned char>& bytes, uint32_t vkFormat)
+{
+    // (bit offset, channel id) of each 64 bit half of the block
+    std::vector<std::pair<uint32_t, uint32_t>> samples;
+    uint32_t colorModel = 0;
+    switch (vkFormat) {
+    case KTX2_BC1_RGB: colorModel = 128; samples = { { 0, 0 } }; break;
+    case KTX2_BC1_RGBA: colorModel = 128; samples = { { 0, 1 } }; break;
+    case KTX2_BC3: colorModel = 130; samples = { { 0, 15 }, { 64, 0 } }; break;
+    case KTX2_BC4: colorModel = 131; samples = { { 0, 0 } }; break;
+    case KTX2_BC5: colorModel = 132; samples = { { 0, 0 }, { 64, 1 } }; break;
+    case KTX2_BC7: colorModel = 134; samples = { { 0, 0 } }; break;
+    }
+    uint32_t blockSize = 24 + 16 * (uint32_t)samples.size();
+    // the single sample of BC7 covers all 128 bits
+    uint32_t sampleBits = vkFormat == KTX2_BC7 ? 128 : 64;
+    writeWord(bytes, 4 + blockSize);
+    writeWord(bytes, 0);                                    // vendor 0 (Khronos), descriptor type 0 (basic)
+    writeWord(bytes, 2 | (blockSize << 16));                // version 1.3
+    writeWord(bytes, colorModel | (1 << 8) | (1 << 16));    // BT.709 primaries, linear transfer, straight alpha
+    writeWord(bytes, 3 | (3 << 8));                         // 4x4 texel blocks (dimensions - 1)
+    writeWord(bytes, (uint32_t)KTX2Texture::blockBytes(vkFormat));
+    writeWord(bytes, 0);
+    for (const std::pair<uint32_t, uint32_t>& sample : samples) {
+        writeWord(bytes, sample.first | ((sampleBits - 1) << 16) | (sample.second << 24));
+        writeWord(bytes, 0);
+        writeWord(bytes, 0);
+        writeWord(bytes, 0xFFFFFFFFu);
+    }
+}
+
+bool KTX2Texture::read(const std::string& path, bool headerOnly)
+{
+    std::ifstream file(path, std::ios::binary);
+    unsigned char header[HEADER_BYTES];
+    if (!file.read(reinterpret_cast<char*>(header), HEADER_BYTES)) return false;
+    if (std::memcmp(header, IDENTIFIER, sizeof(IDENTIFIER)) != 0) return false;
+
+    vkFormat = readWord(header + 12);
+    width = (int)readWord(header + 20);
+    height = (int)readWord(header + 24);
+    uint32_t depth = readWord(header + 28), layers = readWord(header + 32), faces = readWord(header + 36);
+    uint32_t fileLevels = readWord(header + 40), supercompression = readWord(header + 44);
+    uint32_t kvdOffset = readWord(header + 56), kvdLength = readWord(header + 60);
+    // plain 2D block compressed textures only
+    if (depth > 1 || layers > 0 || faces != 1 || supercompression != 0 || blockBytes(vkFormat) == 0 || width <= 0 || height <= 0)
+        return false;
+    levelCount = (int)std::max(1u, fileLevels);
+
+    std::vector<unsigned char> levelIndex(levelCount * LEVEL_INDEX_BYTES);
+    if (!file.read(reinterpret_cast<char*>(levelIndex.data()), levelIndex.size())) return false;
+
+    metadata.clear();
+    if (kvdLength > 0) {
+        std::vector<unsigned char> kvd(kvdLength);
+        file.seekg(kvdOffset);
+        if (!file.read(reinterpret_cast<char*>(kvd.data()), kvd.size())) return false;
+        size_t position = 0;
+        while (position + 4 <= kvd.size()) {
+            uint32_t length = readWord(&kvd[position]);
+            position += 4;
+            if (position + length > kvd.size()) return false;
+            const char* entry = reinterpret_cast<const char*>(&kvd[position]);
+            size_t keyLength = strnlen(entry, length);
+            std::string value(entry + std::min((size_t)length, keyLength + 1), entry + length);
+            // string values carry their terminator
+            if (!value.empty() && value.back() == '\0') value.pop_back();
+            metadata[std::string(entry, keyLength)] = value;
+            position += (length + 3) & ~3u;
+        }
+    }
+
+    levels.clear();
+    if (headerOnly) return true;
+    levels.resize(levelCount);
+    for (int level = 0; level < levelCount; level++) {
+        uint64_t offset = readQuadWord(&levelIndex[level * LEVEL_INDEX_BYTES]);
+        uint64_t length = readQuadWord(&levelIndex[level * LEVEL_INDEX_BYTES + 8]);
+        if (length != levelBytes(vkFormat, std::max(1, width >> level), std::max(1, height >> level))) return false;
+        levels[level].resize((size_t)length);
+        file.seekg((std::streamoff)offset);
+        if (!file.read(reinterpret_cast<char*>(levels[level].data()), (std::streamsize)length)) return false;
+    }
+    return true;
+}
+
+bool KTX2Texture::write(const std::string& path) const
+{
+    int alignment = blockBytes(vkFormat);
+    if (alignment == 0 || levels.empty()) return false;
+
+    std::vector<unsigned char> descriptor, keyValues;
+    writeDataFormatDescriptor(descriptor, vkFormat);
+    // std::map keeps the keys sorted by their bytes, as the format requires
+    for (const auto& entry : metadata) {
+        writeWord(keyValues, (uint32_t)(entry.first.size() + entry.second.size() + 2));
+        keyValues.insert(keyValues.end(), entry.first.begin(), entry.first.end());
+        keyValues.push_back(0);
+        keyValues.insert(keyValues.end(), entry.second.begin(), entry.second.end());
+        keyValues.push_back(0);
+        pad(keyValues, 4);
+    }
+
+    size_t dfdOffset = HEADER_BYTES + levels.size() * LEVEL_INDEX_BYTES;
+    size_t kvdOffset = dfdOffset + descriptor.size();
+    // mip levels are stored smallest first, each aligned to the block size
+    std::vector<size_t> levelOffsets(levels.size());
+    size_t end = kvdOffset + keyValues.size();
+    for (size_t level = levels.size(); level-- > 0;) {
+        end = (end + alignment - 1) / alignment * alignment;
+        levelOffsets[level] = end;
+        end += levels[level].size();
+    }
+
+    std::vector<unsigned char> bytes(IDENTIFIER, IDENTIFIER + sizeof(IDENTIFIER));
+    writeWord(bytes, vkFormat);
+    writeWord(bytes, 1);                                // typeSize of block formats
+    writeWord(bytes, (uint32_t)width);
+    writeWord(bytes, (uint32_t)height);
+    writeWord(bytes, 0);                                // depth
+    writeWord(bytes, 0);                                // layers
+    writeWord(bytes, 1);                                // faces
+    writeWord(bytes, (uint32_t)levels.size());
+    writeWord(bytes, 0);                                // no supercompression
+    writeWord(bytes, (uint32_t)dfdOffset);
+    writeWord(bytes, (uint32_t)descriptor.size());
+    writeWord(bytes, keyValues.empty() ? 0 : (uint32_t)kvdOffset);
+    writeWord(bytes, (uint32_t)keyValues.size());
+    writeQuadWord(bytes, 0);                            // no supercompression global data
+    writeQuadWord(bytes, 0);
+    for (size_t level = 0; level < levels.size(); level++) {
+        writeQuadWord(bytes, levelOffsets[level]);
+        writeQuadWord(bytes, levels[level].size());
+        writeQuadWord(bytes, levels[level].size());
+    }
+    bytes.insert(bytes.end(), descriptor.begin(), descriptor.end());
+    bytes.insert(bytes.end(), keyValues.begin(), keyValues.end());
+    for (size_t level = levels.size(); level-- > 0;) {
+        bytes.resize(levelOffsets[level], 0);
+        bytes.insert(bytes.end(), levels[level].begin(), levels[level].end());
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    return file && file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+GLenum KTX2Texture::glFormat() const
+{
+    switch (vkFormat) {
+    case KTX2_BC1_RGB: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case KTX2_BC1_RGBA: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case KTX2_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case KTX2_BC4: return GL_COMPRESSED_RED_RGTC1;
+    case KTX2_BC5: return GL_COMPRESSED_RG_RGTC2;
+    case KTX2_BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    return 0;
+}
+
+AlphaMode KTX2Texture::alphaMode() const
+{
+    auto name = metadata.find("alphaMode");
+    bool hasAlpha = vkFormat == KTX2_BC1_RGBA || vkFormat == KTX2_BC3 || vkFormat == KTX2_BC7;
+    // cutout draws correctly whether or not the texture really has holes
+    AlphaMode fallback = hasAlpha ? ALPHA_CUTOUT : ALPHA_OPAQUE;
+    return name == metadata.end() ? fallback : alphaModeFromName(name->second, fallback);
+}
+
+int KTX2Texture::blockBytes(uint32_t vkFormat)
+{
+    switch (vkFormat) {
+    case KTX2_BC1_RGB:
+    case KTX2_BC1_RGBA:
+    case KTX2_BC4:
+        return 8;
+    case KTX2_BC3:
+    case KTX2_BC5:
+    case KTX2_BC7:
+        return 16;
+    }
+    return 0;
+}
+
+int KTX2Texture::glBlockBytes(GLenum glFormat)
+{
+    switch (glFormat) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RED_RGTC1:
+        return 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        return 16;
+    }
+    return 0;
+}
+
+size_t KTX2Texture::levelBytes(uint32_t vkFormat, int width, int height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(vkFormat);
+}
+
+std::string KTX2Texture::cookedPath(const std::string& source)
+{
+    size_t dot = source.find_last_of('.'), slash = source.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return source + ".ktx2";
+    return source.substr(0, dot) + ".ktx2";
+}
+
+bool KTX2Texture::findCooked(const std::string& source, bool flip, KTX2Texture& texture, bool headerOnly)
+{
+    std::string path = cookedPath(source);
+    std::error_code error;
+    auto cookedTime = std::filesystem::last_write_time(path, error);
+    if (error) return false;
+    // a source edited after cooking wins (a missing source is fine)
+    auto sourceTime = std::filesystem::last_write_time(source, error);
+    if (!error && sourceTime > cookedTime) return false;
+    if (!texture.read(path, headerOnly)) return false;
+
+    // KTX2 rows go top to bottom ("rd") unless the file says otherwise, flipped images go up ("ru")
+    auto orientation = texture.metadata.find("KTXorientation");
+    bool cookedFlipped = orientation != texture.metadata.end() && orientation->second.size() >= 2 && orientation->second[1] == 'u';
+    if (cookedFlipped != flip) return false;
+    int fullChain = 1;
+    while ((std::max(texture.width, texture.height) >> fullChain) > 0) fullChain++;
+    return texture.levelCount == fullChain;
+}
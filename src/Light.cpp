@@ -1,27 +1,18 @@
 #include "Light.h"
 
-Light::Light(){}
+Light::Light() : version(0) {}
 
-Light::Light(Shader shader, bool enableDir, int numOfPoints, bool enableSpot)
+Light::Light(Shader shader, bool enableDir, int numOfPoints, bool enableSpot) : version(0)
 {
-    this->myShader = shader;
     this->enableDir = enableDir;
-    this->numOfPoints = numOfPoints;
     this->enableSpot = enableSpot;
     //DirLight:
     this->dirLightColor = glm::vec3(1.0f);
     this->dirLightDirection = glm::vec3(0.0f, 0.0f, 90.0f);
     this->dirLightSpecular = glm::vec3(1.0f);
     //PointLight:
-    for(int i=0; i<numOfPoints; i++){
-        this->pointLightColor[i]= glm::vec3(1.0f);
-        this->pointLightSpecular[i]=glm::vec3(1.0f);
-        this->pointLightConstant[i] =1.0f;
-        this->pointLightLinear[i]=0.09f;
-        this->pointLightQuadratic[i] = 0.032f;
-        this->pointLightPosition[i] = glm::vec3( 0.7f,  0.2f,  2.0f); 
-        
-    }
+    for(int i=0; i<numOfPoints; i++)
+        addPointLight(glm::vec3( 0.7f,  0.2f,  2.0f));
     //SpotLight:
     this->spotLightColor = glm::vec3(1.0f);
     
@@ -32,17 +23,21 @@ Light::Light(Shader shader, bool enableDir, int numOfPoints, bool enableSpot)
     this->spotLightCutOff = 12.5f;
     this->spotLightOuterCutOff = 17.5f;
     
-    myShader.use();
+    // point light
+    turnOnPoint();
+    addShader(shader);
+    
+}
+void Light::addShader(Shader shader)
+{
+    myShaders.push_back(shader);
+    shader.use();
+    shader.setBool("enableDir", enableDir);
+    shader.setBool("enableSpot", enableSpot);
     //Dir light
-    myShader.setBool("enableDir", enableDir);
     if(enableDir) turnOnDir();
-    // point light 
-    myShader.setInt("numOfPoints", numOfPoints);
-    turnOnPoint();
     // spotLight
-    myShader.setBool("enableSpot", enableSpot);
     if(enableSpot) turnOnSpot();
-    
 }
 void Light::update(glm::vec3 cameraPos, glm::vec3 cameraFront)
 {
@@ -50,51 +45,70 @@ void Light::update(glm::vec3 cameraPos, glm::vec3 cameraFront)
     spotLightDirection = cameraFront;
     //viewPos:
     viewPos = cameraPos;
-    myShader.setVec3("viewPos", viewPos);
+    for(Shader& shader : myShaders){
+        shader.use();
+        shader.setVec3("viewPos", viewPos);
+    }
 
 }
 void Light::turnOnDir()
 {
-    myShader.use();
     this->dirLightDiffuse = this->dirLightColor * glm::vec3(0.8f);
     this->dirLightAmbient = this->dirLightDiffuse * glm::vec3(0.2f);
-    myShader.setVec3("dirLight.direction", dirLightDirection);
-    myShader.setVec3("dirLight.specular", dirLightSpecular);
-    myShader.setVec3("dirLight.ambient", dirLightAmbient);
-    myShader.setVec3("dirLight.diffuse", dirLightDiffuse);
+    version++;
+    for(Shader& shader : myShaders){
+        shader.use();
+        shader.setVec3("dirLight.direction", dirLightDirection);
+        shader.setVec3("dirLight.specular", dirLightSpecular);
+        shader.setVec3("dirLight.ambient", dirLightAmbient);
+        shader.setVec3("dirLight.diffuse", dirLightDiffuse);
+    }
     
 }
+int Light::addPointLight(glm::vec3 position, glm::vec3 color)
+{
+    PointLight point;
+    point.position = position;
+    point.color = color;
+    point.specular = glm::vec3(1.0f);
+    point.constant = 1.0f;
+    point.linear = 0.09f;
+    point.quadratic = 0.032f;
+    pointLights.push_back(point);
+    turnOnPoint();
+    return (int)pointLights.size() - 1;
+}
 void Light::turnOnPoint()
 {
-    myShader.use();
-    for(int i=0; i<numOfPoints; i++){
-        this->pointLightDiffuse[i] = this->pointLightColor[i] * glm::vec3(0.8f);
-        this->pointLightAmbient[i] = this->pointLightDiffuse[i] * glm::vec3(0.2f);
-    }
-    for(char x = '0'; x-'0'<numOfPoints; x++){
-        std::string ch; ch += x;
-        myShader.setVec3("pointLights["+ch+"].position", pointLightPosition[x-'0']);
-        myShader.setVec3("pointLights["+ch+"].ambient", pointLightAmbient[x-'0']);
-        myShader.setVec3("pointLights["+ch+"].diffuse", pointLightDiffuse[x-'0']);
-        myShader.setVec3("pointLights["+ch+"].specular", pointLightSpecular[x-'0']);
-        myShader.setFloat("pointLights["+ch+"].constant", pointLightConstant[x-'0']);
-        myShader.setFloat("pointLights["+ch+"].linear", pointLightLinear[x-'0']);
-        myShader.setFloat("pointLights["+ch+"].quadratic", pointLightQuadratic[x-'0']);
+    // the lights are uploaded per frame by the renderer's light clusters
+    version++;
+    for(PointLight& point : pointLights){
+        point.diffuse = point.color * glm::vec3(0.8f);
+        point.ambient = point.diffuse * glm::vec3(0.2f);
+        // solve intensity / (constant + linear*d + quadratic*d^2) = 1/256 for d
+        float intensity = glm::max(point.diffuse.r, glm::max(point.diffuse.g, point.diffuse.b)) + glm::max(point.ambient.r, glm::max(point.ambient.g, point.ambient.b));
+        float c = point.constant - 256.0f * intensity;
+        if(point.quadratic > 0.0f)
+            point.radius = (-point.linear + glm::sqrt(point.linear * point.linear - 4.0f * point.quadratic * c)) / (2.0f * point.quadratic);
+        else
+            point.radius = point.linear > 0.0f ? -c / point.linear : 1e30f;
     }
 }
 void Light::turnOnSpot()
 {
-    myShader.use();
     this->spotLightDiffuse = this->spotLightColor * glm::vec3(0.8f);
     this->spotLightAmbient = this->spotLightDiffuse * glm::vec3(0.2f);
-    myShader.setVec3("spotLight.position", spotLightPosition);
-    myShader.setVec3("spotLight.direction", spotLightDirection);
-    myShader.setVec3("spotLight.ambient", spotLightAmbient);
-    myShader.setVec3("spotLight.diffuse", spotLightDiffuse);
-    myShader.setVec3("spotLight.specular", spotLightSpecular);
-    myShader.setFloat("spotLight.constant", spotLightConstant);
-    myShader.setFloat("spotLight.linear", spotLightLinear);
-    myShader.setFloat("spotLight.quadratic", spotLightQuadratic);
-    myShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(spotLightCutOff)));
-    myShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(spotLightOuterCutOff)));
+    for(Shader& shader : myShaders){
+        shader.use();
+        shader.setVec3("spotLight.position", spotLightPosition);
+        shader.setVec3("spotLight.direction", spotLightDirection);
+        shader.setVec3("spotLight.ambient", spotLightAmbient);
+        shader.setVec3("spotLight.diffuse", spotLightDiffuse);
+        shader.setVec3("spotLight.specular", spotLightSpecular);
+        shader.setFloat("spotLight.constant", spotLightConstant);
+        shader.setFloat("spotLight.linear", spotLightLinear);
+        shader.setFloat("spotLight.quadratic", spotLightQuadratic);
+        shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(spotLightCutOff)));
+        shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(spotLightOuterCutOff)));
+    }
 }
@@ -0,0 +1,78 @@
+#include "LoadGraph.h"
+#include <iostream>
+
+LoadGraph::LoadGraph(JobSystem& jobs) : jobs(jobs), uploads(nullptr), cancelled(false) {}
+
+LoadGraph::~LoadGraph()
+{
+	// the stages capture the owner, none may run after it is gone
+	cancelled = true;
+	waitAll();
+}
+
+void LoadGraph::add(const std::string& name, std::function<void()> cpu, std::function<void()> upload, std::function<void()> gl,
+                    const std::vector<std::string>& dependencies)
+{
+	if (nodes.count(name)) {
+		std::cout << "ERROR::LOAD_GRAPH:: " << name << " is added twice" << std::endl;
+		return;
+	}
+	Node* node = new Node();
+	node->cpu = std::move(cpu);
+	node->upload = std::move(upload);
+	node->gl = std::move(gl);
+	nodes[name].reset(node);
+
+	// one empty job per dependency holds node->dependencies up until it is done
+	for (const std::string& dependency : dependencies) {
+		auto found = nodes.find(dependency);
+		if (found == nodes.end()) {
+			std::cout << "ERROR::LOAD_GRAPH:: " << name << " depends on unknown " << dependency << std::endl;
+			continue;
+		}
+		jobs.runAfter(found->second->done, [] {}, &node->dependencies, JobPriority::Background);
+	}
+	jobs.runAfter(node->dependencies, [this, node] {
+		if (node->cpu && !cancelled) node->cpu();
+	}, &node->cpuDone, JobPriority::Background);
+	// node->done stays up from here until the GL stage ran
+	jobs.runAfter(node->cpuDone, [this, node] {
+		std::function<void()> gl = [this, node] {
+			if (node->gl && !cancelled) node->gl();
+		};
+		if (node->upload && uploads) {
+			uploads->upload([this, node] {
+				if (!cancelled) node->upload();
+			}, gl, &node->done);
+		} else if (node->upload || node->gl) {
+			jobs.runOnGLThread([this, node, gl] {
+				if (node->upload && !cancelled) node->upload();
+				gl();
+			}, &node->done);
+		}
+	}, &node->done, JobPriority::Background);
+}
+
+bool LoadGraph::done(const std::string& name) const
+{
+	auto found = nodes.find(name);
+	return found != nodes.end() && found->second->done.done();
+}
+
+bool LoadGraph::allDone() const
+{
+	for (auto& node : nodes)
+		if (!node.second->done.done()) return false;
+	return true;
+}
+
+void LoadGraph::wait(const std::string& name)
+{
+	auto found = nodes.find(name);
+	if (found != nodes.end()) jobs.wait(found->second->done);
+}
+
+void LoadGraph::waitAll()
+{
+	for (auto& node : nodes) jobs.wait(node.second->done);
+}
@@ -0,0 +1,24 @@
+#include"LodMesh.h"
+
+LodMesh::LodMesh() : boundingRadius(0.0f) {}
+
+// every level is used down to a quarter of the projected radius of the previous one,
+// the coarsest level takes everything below that
+void LodMesh::setScreenRadii()
+{
+	minScreenRadius.clear();
+	float radius = 64.0f;
+	for (std::size_t i = 0; i < levels.size(); i++)
+	{
+		minScreenRadius.push_back(i + 1 < levels.size() ? radius : 0.0f);
+		radius *= 0.25f;
+	}
+}
+
+int LodMesh::selectLevel(float screenRadius, float bias) const
+{
+	for (std::size_t i = 0; i + 1 < levels.size(); i++)
+		if (screenRadius >= minScreenRadius[i] * bias)
+			return (int)i;
+	return (int)levels.size() - 1;
+}
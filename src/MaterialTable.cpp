@@ -0,0 +1,60 @@
+#include "MaterialTable.h"
+#include <cstring>
+
+static GLuint floatBits(float value)
+{
+    GLuint bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+MaterialTable::MaterialTable()
+{
+    materials.push_back(Material());
+    glGenBuffers(1, &buffer);
+    glGenTextures(1, &texture);
+    upload();
+}
+
+int MaterialTable::add(const Material& material)
+{
+    for (size_t i = 0; i < materials.size(); i++)
+        if (materials[i] == material) return (int)i;
+    materials.push_back(material);
+    return (int)materials.size() - 1;
+}
+
+void MaterialTable::upload()
+{
+    std::vector<glm::uvec4> texels;
+    texels.reserve(materials.size() * TEXELS_PER_MATERIAL);
+    for (const Material& material : materials)
+    {
+        texels.push_back(glm::uvec4(material.textureSlots));
+        texels.push_back(glm::uvec4(floatBits(material.shininess), (GLuint)material.alphaMode, floatBits(material.textureCnt), 0u));
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER, texels.size() * sizeof(glm::uvec4), texels.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    // anything drawn without setting a material uses the default one
+    glVertexAttribI1i(MATERIAL_LOCATION, 0);
+}
+
+void MaterialTable::bind(Shader& shader) const
+{
+    glActiveTexture(GL_TEXTURE0 + UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setInt("materials", UNIT);
+}
+
+void MaterialTable::Delete()
+{
+    glDeleteTextures(1, &texture);
+    glDeleteBuffers(1, &buffer);
+    materials.clear();
+}
@@ -1,24 +1,37 @@
 #include "Model.h"
+#include "TextureArrays.h"
+#include "TextureStreamer.h"
+#include "TextureCache.h"
 #include <iostream>
-#include <cstring>
 
 // Default constructor
 Model::Model() {}
 
 // Constructor with path and gammaCorrection
-Model::Model(const std::string &path, bool gamma) : gammaCorrection(gamma) {
-    loadModel(path);
+Model::Model(const std::string &path, bool gamma, TextureArrays* textureArrays, TextureStreamer* streamer) : gammaCorrection(gamma) {
+    if (import(path)) upload(textureArrays, streamer);
 }
 
 // Draw function
-void Model::Draw(Shader &shader) {
+void Model::Draw() {
     for (unsigned int i = 0; i < meshes.size(); i++) {
-        meshes[i].Draw(shader);
+        meshes[i].Draw();
     }
 }
 
-// Load the model
-void Model::loadModel(const std::string &path) {
+// Take the array slots of the queued textures
+void Model::resolveTextures(const TextureArrays& textureArrays) {
+    for (Texture& texture : textures_loaded)
+        textureArrays.resolve(texture, directory);
+    for (Mesh& mesh : meshes) {
+        for (Texture& texture : mesh.textures)
+            textureArrays.resolve(texture, directory);
+        mesh.updateMaterialTextures();
+    }
+}
+
+// Load the model (the textures are only named here, upload() creates them)
+bool Model::import(const std::string &path) {
     Assimp::Importer importer;
     const aiScene* scene = importer.ReadFile(
         path, 
@@ -28,11 +41,35 @@ void Model::loadModel(const std::string &path) {
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
-        return;
+        return false;
     }
 
     directory = path.substr(0, path.find_last_of('/'));
     processNode(scene->mRootNode, scene);
+    return true;
+}
+
+// Fill the mesh buffers of an imported model
+void Model::uploadBuffers() {
+    for (Mesh& mesh : meshes)
+        mesh.createBuffers();
+}
+
+// Create the GL side of an imported model
+void Model::upload(TextureArrays* textureArrays, TextureStreamer* streamer) {
+    for (Texture& texture : textures_loaded) {
+        if (textureArrays) textureArrays->add(directory + '/' + texture.path);
+        else texture.id = TextureFromFile(texture.path.c_str(), directory, false, &texture.alphaMode, streamer);
+    }
+    for (Mesh& mesh : meshes) {
+        for (Texture& texture : mesh.textures) {
+            const Texture& loaded = textures_loaded[loadedIndex[texture.path]];
+            texture.id = loaded.id;
+            texture.alphaMode = loaded.alphaMode;
+        }
+        mesh.updateMaterialTextures();
+        mesh.createVertexArray();
+    }
 }
 
 // Process each node
@@ -110,7 +147,11 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
     std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
     textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-    return Mesh(vertices, indices, textures);
+    Mesh result(vertices, indices, textures, false);
+    float shininess = 0.0f;
+    if (material->Get(AI_MATKEY_SHININESS, shininess) == aiReturn_SUCCESS && shininess > 0.0f)
+        result.material.shininess = shininess;
+    return result;
 }
 
 // Load material textures
@@ -120,21 +161,16 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType
         aiString str;
         mat->GetTexture(type, i, &str);
 
-        bool skip = false;
-        for (unsigned int j = 0; j < textures_loaded.size(); j++) {
-            if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0) {
-                textures.push_back(textures_loaded[j]);
-                skip = true;
-                break;
-            }
-        }
-
-        if (!skip) {
+        auto loaded = loadedIndex.find(str.C_Str());
+        if (loaded != loadedIndex.end()) {
+            textures.push_back(textures_loaded[loaded->second]);
+        } else {
             Texture texture;
-            texture.id = TextureFromFile(str.C_Str(), directory);
+            texture.id = 0;
             texture.type = typeName;
             texture.path = str.C_Str();
             textures.push_back(texture);
+            loadedIndex[texture.path] = textures_loaded.size();
             textures_loaded.push_back(texture);
         }
     }
@@ -142,32 +178,21 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType
 }
 
 // Load texture from file
-unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma) {
+unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma, int *alphaMode, TextureStreamer *streamer) {
     std::string filename = std::string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format = (nrComponents == 1) ? GL_RED : (nrComponents == 3 ? GL_RGB : GL_RGBA);
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
+    // shared with every other loader of the same image, only the first sets the sampler
+    bool created;
+    unsigned int textureID = TextureCache::acquire2D(filename, 0, true, streamer, alphaMode, &created);
+    if (!created) return textureID;
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
     return textureID;
 }
@@ -0,0 +1,111 @@
+#include "PostAntiAliasing.h"
+#include <iostream>
+
+static GLuint createTarget(GLenum internalFormat, GLenum format, GLenum type, GLenum filter, unsigned int width, unsigned int height)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+static GLuint createFramebuffer(GLuint texture)
+{
+	GLuint FBO;
+	glGenFramebuffers(1, &FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::POST_ANTI_ALIASING:: framebuffer is not complete" << std::endl;
+	return FBO;
+}
+
+// radical inverse of index in base, 1-based indices skip the (0, 0) corner
+static float halton(unsigned int index, unsigned int base)
+{
+	float fraction = 1.0f, result = 0.0f;
+	while (index > 0) {
+		fraction /= base;
+		result += fraction * (index % base);
+		index /= base;
+	}
+	return result;
+}
+
+PostAntiAliasing::PostAntiAliasing() : mode(AntiAliasing::None), outputFBO(0), output(0), velocityFBO(0), velocity(0),
+	current(0), width(0), height(0), lastViewProjection(1.0f), lastUvScale(1.0f), hasHistory(false), frame(0)
+{
+	historyFBO[0] = historyFBO[1] = history[0] = history[1] = 0;
+}
+
+PostAntiAliasing::PostAntiAliasing(unsigned int width, unsigned int height, AntiAliasing mode)
+	: PostAntiAliasing()
+{
+	this->mode = mode;
+	this->width = width;
+	this->height = height;
+	if (mode == AntiAliasing::FXAA) {
+		output = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_LINEAR, width, height);
+		outputFBO = createFramebuffer(output);
+	} else if (mode == AntiAliasing::TAA) {
+		velocity = createTarget(GL_RG16F, GL_RG, GL_FLOAT, GL_NEAREST, width, height);
+		velocityFBO = createFramebuffer(velocity);
+		// linear: the history is read between pixels wherever something moved
+		for (int i = 0; i < 2; i++) {
+			history[i] = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_LINEAR, width, height);
+			historyFBO[i] = createFramebuffer(history[i]);
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+glm::vec2 PostAntiAliasing::jitter() const
+{
+	if (mode != AntiAliasing::TAA) return glm::vec2(0.0f);
+	unsigned int index = frame % JITTER_PHASES + 1;
+	return glm::vec2(halton(index, 2), halton(index, 3)) - 0.5f;
+}
+
+glm::mat4 PostAntiAliasing::jitterProjection(const glm::mat4& projection, glm::vec2 renderSize) const
+{
+	// a pixel is 2 / size in NDC; the third column is multiplied by z = -w, so this is a shift after the divide
+	glm::vec2 offset = jitter() * 2.0f / renderSize;
+	glm::mat4 jittered = projection;
+	jittered[2][0] -= offset.x;
+	jittered[2][1] -= offset.y;
+	return jittered;
+}
+
+void PostAntiAliasing::bindOutput(GLuint FBO, glm::vec2 renderSize)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glViewport(0, 0, (GLsizei)renderSize.x, (GLsizei)renderSize.y);
+}
+
+GLuint PostAntiAliasing::result() const
+{
+	return mode == AntiAliasing::TAA ? history[current] : output;
+}
+
+void PostAntiAliasing::endFrame(const glm::mat4& viewProjection, glm::vec2 uvScale)
+{
+	lastViewProjection = viewProjection;
+	lastUvScale = uvScale;
+	hasHistory = mode == AntiAliasing::TAA;
+	current = 1 - current;
+	frame++;
+}
+
+void PostAntiAliasing::Delete()
+{
+	GLuint framebuffers[4] = { outputFBO, velocityFBO, historyFBO[0], historyFBO[1] };
+	GLuint textures[4] = { output, velocity, history[0], history[1] };
+	glDeleteFramebuffers(4, framebuffers);
+	glDeleteTextures(4, textures);
+}
@@ -0,0 +1,136 @@
+#include "PrimitiveRegistry.h"
+#include <algorithm>
+
+// first size of every buffer, they double from there
+static const GLsizeiptr INITIAL_CAPACITY = 64 * 1024;
+
+PrimitiveRegistry::PrimitiveRegistry() : vertexCount(0), indexCount(0), VAO(0), vertexBuffer(0), indexBuffer(0),
+	instanceBuffer(0), vertexCapacity(0), indexCapacity(0), instanceCapacity(0), pointedInstance(0) {}
+
+int PrimitiveRegistry::add(const float* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount,
+                           float boundingRadius)
+{
+	// handles count everything added, uploaded or not
+	GLuint firstVertex = this->vertexCount + (GLuint)(pendingVertices.size() / VERTEX_FLOATS);
+	GLuint firstIndex = this->indexCount + (GLuint)pendingIndices.size();
+	pendingVertices.insert(pendingVertices.end(), vertices, vertices + vertexCount * VERTEX_FLOATS);
+	pendingIndices.insert(pendingIndices.end(), indices, indices + indexCount);
+	primitives.push_back({ (GLsizei)indexCount, firstIndex, (GLint)firstVertex, boundingRadius });
+	return (int)primitives.size() - 1;
+}
+
+void PrimitiveRegistry::grow(GLuint& buffer, GLsizeiptr& capacity, GLsizeiptr size, GLsizeiptr keep, GLenum usage)
+{
+	if (size <= capacity) return;
+	GLsizeiptr grown = std::max(capacity, INITIAL_CAPACITY);
+	while (grown < size) grown *= 2;
+	GLuint old = buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, grown, nullptr, usage);
+	if (old && keep > 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, old);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, keep);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	if (old) glDeleteBuffers(1, &old);
+	capacity = grown;
+}
+
+void PrimitiveRegistry::upload()
+{
+	if (!VAO) glGenVertexArrays(1, &VAO);
+	if (pendingVertices.empty() && pendingIndices.empty() && vertexBuffer) return;
+
+	GLsizeiptr vertexBytes = (GLsizeiptr)vertexCount * VERTEX_FLOATS * sizeof(float);
+	GLsizeiptr indexBytes = (GLsizeiptr)indexCount * sizeof(GLuint);
+	GLsizeiptr newVertexBytes = (GLsizeiptr)(pendingVertices.size() * sizeof(float));
+	GLsizeiptr newIndexBytes = (GLsizeiptr)(pendingIndices.size() * sizeof(GLuint));
+	grow(vertexBuffer, vertexCapacity, vertexBytes + newVertexBytes, vertexBytes, GL_STATIC_DRAW);
+	grow(indexBuffer, indexCapacity, indexBytes + newIndexBytes, indexBytes, GL_STATIC_DRAW);
+	grow(instanceBuffer, instanceCapacity, 1, 0, GL_DYNAMIC_DRAW);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, vertexBytes, newVertexBytes, pendingVertices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, indexBytes, newIndexBytes, pendingIndices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	vertexCount += (GLuint)(pendingVertices.size() / VERTEX_FLOATS);
+	indexCount += (GLuint)pendingIndices.size();
+	// the shapes are on the GPU now
+	std::vector<float>().swap(pendingVertices);
+	std::vector<unsigned int>().swap(pendingIndices);
+	linkAttributes();
+}
+
+void PrimitiveRegistry::linkAttributes()
+{
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	GLsizei stride = VERTEX_FLOATS * sizeof(float);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+	// the instance matrix (4 times vec4)
+	for (int i = 0; i < 4; i++) {
+		glEnableVertexAttribArray(3 + i);
+		glVertexAttribDivisor(3 + i, 1);
+	}
+	pointInstances(0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// VAO bound
+void PrimitiveRegistry::pointInstances(GLuint first)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	for (int i = 0; i < 4; i++)
+		glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(first * sizeof(glm::mat4) + i * sizeof(glm::vec4)));
+	pointedInstance = first;
+}
+
+void PrimitiveRegistry::setInstances(GLuint first, const glm::mat4* matrices, GLsizei count)
+{
+	if (count <= 0 || !VAO) return;
+	GLsizeiptr end = (GLsizeiptr)(first + count) * sizeof(glm::mat4);
+	if (end > instanceCapacity) {
+		grow(instanceBuffer, instanceCapacity, end, first * sizeof(glm::mat4), GL_DYNAMIC_DRAW);
+		linkAttributes();
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::mat4), count * sizeof(glm::mat4), matrices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void PrimitiveRegistry::draw(const Draw* draws, size_t count)
+{
+	if (count == 0 || !vertexBuffer) return;
+	glBindVertexArray(VAO);
+	// GL 3.3 has no base instance: the matrix attributes move instead
+	for (size_t i = 0; i < count; i++) {
+		if (draws[i].instanceCount <= 0) continue;
+		const Primitive& primitive = primitives[draws[i].primitive];
+		if (draws[i].firstInstance != pointedInstance) pointInstances(draws[i].firstInstance);
+		glDrawElementsInstancedBaseVertex(GL_TRIANGLES, primitive.indexCount, GL_UNSIGNED_INT,
+			(void*)(primitive.firstIndex * sizeof(GLuint)), draws[i].instanceCount, primitive.baseVertex);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void PrimitiveRegistry::Delete()
+{
+	GLuint buffers[] = { vertexBuffer, indexBuffer, instanceBuffer };
+	glDeleteBuffers(3, buffers);
+	glDeleteVertexArrays(1, &VAO);
+	vertexBuffer = indexBuffer = instanceBuffer = VAO = 0;
+	vertexCapacity = indexCapacity = instanceCapacity = 0;
+	vertexCount = indexCount = 0;
+	primitives.clear();
+}
@@ -1,52 +1,19 @@
 #include "Skybox.h"
+#include "TextureCache.h"
 #include <stb_image.h>
 #include <iostream>
-
-// Skybox vertices
-static const float skyboxVertices[] =  {
-        // positions          
-        -1.0f,  1.0f, -1.0f,
-        -1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-         1.0f,  1.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f,
-
-        -1.0f, -1.0f,  1.0f,
-        -1.0f, -1.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f,
-        -1.0f,  1.0f, -1.0f,
-        -1.0f,  1.0f,  1.0f,
-        -1.0f, -1.0f,  1.0f,
-
-         1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-
-        -1.0f, -1.0f,  1.0f,
-        -1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f, -1.0f,  1.0f,
-        -1.0f, -1.0f,  1.0f,
-
-        -1.0f,  1.0f, -1.0f,
-         1.0f,  1.0f, -1.0f,
-         1.0f,  1.0f,  1.0f,
-         1.0f,  1.0f,  1.0f,
-        -1.0f,  1.0f,  1.0f,
-        -1.0f,  1.0f, -1.0f,
-
-        -1.0f, -1.0f, -1.0f,
-        -1.0f, -1.0f,  1.0f,
-         1.0f, -1.0f, -1.0f,
-         1.0f, -1.0f, -1.0f,
-        -1.0f, -1.0f,  1.0f,
-         1.0f, -1.0f,  1.0f
-    };
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_TEXTURE_CUBE_MAP_SEAMLESS
+#define GL_TEXTURE_CUBE_MAP_SEAMLESS 0x884F
+#endif
 
 static const std::vector<std::string> morningFaces = {
         "../resources/objects/skybox/morning2/right.jpg",
@@ -66,69 +33,193 @@ static const std::vector<std::string> eveningFaces = {
         "../resources/objects/skybox/night/back.jpg"
 };
 
-Skybox::Skybox() {
-    // Load textures
-    stbi_set_flip_vertically_on_load(false);
-    cubemapTextureMorning = loadCubemap(morningFaces);
-    cubemapTextureEvening = loadCubemap(eveningFaces);
-    currentTexture = cubemapTextureMorning;
-
-    // Setup VAO and VBO
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+static const std::string morningCache = "../resources/objects/skybox/morning2/cubemap.cache";
+static const std::string eveningCache = "../resources/objects/skybox/night/cubemap.cache";
+
+// Cache layout: header, then for every level and face (level-major) a uint32
+// byte count followed by the compressed data as returned by the driver.
+struct CubemapCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t internalFormat;
+    int32_t size;
+    int32_t levels;
+};
+static const char CACHE_MAGIC[4] = { 'C', 'U', 'B', 'E' };
+static const uint32_t CACHE_VERSION = 1;
+
+// the cache is stale as soon as one face is newer than it
+static bool cacheFresh(const std::vector<std::string>& faces, const std::string& cachePath) {
+    std::error_code error;
+    auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+    if (error) return false;
+    for (const std::string& face : faces) {
+        auto faceTime = std::filesystem::last_write_time(face, error);
+        if (!error && faceTime > cacheTime) return false;
+    }
+    return true;
 }
 
-
-Skybox::~Skybox() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteTextures(1, &cubemapTextureMorning);
-    glDeleteTextures(1, &cubemapTextureEvening);
+// reads the cached levels, false if the cache can't be used (formats: what the driver supports)
+static bool readCache(const std::string& cachePath, const std::vector<GLint>& formats, StreamedImage& image) {
+    std::ifstream file(cachePath, std::ios::binary);
+    CubemapCacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.magic, CACHE_MAGIC, 4) != 0 || header.version != CACHE_VERSION) return false;
+    if (header.size <= 0 || header.levels <= 0) return false;
+    if (std::find(formats.begin(), formats.end(), (GLint)header.internalFormat) == formats.end()) return false;
+
+    image.compressed = true;
+    image.internalFormat = header.internalFormat;
+    for (int level = 0; level < header.levels; level++) {
+        int size = std::max(1, header.size >> level);
+        for (int face = 0; face < 6; face++) {
+            uint32_t byteCount;
+            if (!file.read(reinterpret_cast<char*>(&byteCount), sizeof(byteCount))) return false;
+            size_t offset = image.data.size();
+            image.data.resize(offset + byteCount);
+            if (!file.read(reinterpret_cast<char*>(image.data.data() + offset), byteCount)) return false;
+            image.levels.push_back({ (GLenum)(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face), level, size, size, offset, byteCount });
+        }
+    }
+    return true;
 }
 
-unsigned int Skybox::loadCubemap(const std::vector<std::string>& faces) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
+// decodes the faces and their mips, the driver compresses every level to compressedFormat on upload
+static bool decodeFaces(const std::vector<std::string>& faces, GLenum compressedFormat, StreamedImage& image) {
+    // cubemap faces are stored the way GL expects them
+    stbi_set_flip_vertically_on_load_thread(false);
+    int size = 0;
     for (unsigned int i = 0; i < faces.size(); i++) {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        } else {
+        int width, height, nrChannels;
+        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 3);
+        if (!data || width != height || (i > 0 && width != size)) {
             std::cout << "Cubemap texture failed to load at path: " << faces[i] << std::endl;
             stbi_image_free(data);
+            return false;
+        }
+        size = width;
+        image.addMips(data, width, height, 3, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i);
+        stbi_image_free(data);
+    }
+    image.internalFormat = compressedFormat;
+    return true;
+}
+
+// reads the compressed levels of a cubemap back and writes them to the cache
+static void writeCache(const std::string& cachePath, unsigned int textureID, int size, int levels) {
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    GLint compressed = GL_FALSE, internalFormat = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_TEXTURE_COMPRESSED, &compressed);
+    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+    // a driver that ignored the compression request has nothing worth caching
+    if (compressed) {
+        std::ofstream file(cachePath, std::ios::binary);
+        if (!file) {
+            std::cout << "ERROR::SKYBOX::CACHE_NOT_WRITABLE " << cachePath << std::endl;
+        } else {
+            CubemapCacheHeader header = { { CACHE_MAGIC[0], CACHE_MAGIC[1], CACHE_MAGIC[2], CACHE_MAGIC[3] }, CACHE_VERSION, (uint32_t)internalFormat, size, levels };
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            std::vector<char> data;
+            for (int level = 0; level < levels; level++)
+                for (int face = 0; face < 6; face++) {
+                    GLint byteCount = 0;
+                    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &byteCount);
+                    data.resize(byteCount);
+                    glGetCompressedTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, data.data());
+                    uint32_t count = (uint32_t)byteCount;
+                    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+                    file.write(data.data(), byteCount);
+                }
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
         }
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+Skybox::Skybox(TextureStreamer* streamer) : night(0.0f) {
+    // Load textures
+    cubemapTextureMorning = loadCubemap(morningFaces, morningCache, streamer);
+    cubemapTextureEvening = loadCubemap(eveningFaces, eveningCache, streamer);
+    // sample across face edges, otherwise the lower mips show the cube seams
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+}
+
+
+Skybox::~Skybox() {
+    triangle.Delete();
+    TextureCache::release(cubemapTextureMorning);
+    TextureCache::release(cubemapTextureEvening);
+}
+
+unsigned int Skybox::loadCubemap(const std::vector<std::string>& faces, const std::string& cachePath, TextureStreamer* streamer) {
+    // a second skybox with the same faces shares the cubemap
+    return TextureCache::acquire(faces, "cube", [&](int&) { return createCubemap(faces, cachePath, streamer); });
+}
+
+unsigned int Skybox::createCubemap(const std::vector<std::string>& faces, const std::string& cachePath, TextureStreamer* streamer) {
+    unsigned int textureID = TextureStreamer::createPlaceholder(GL_TEXTURE_CUBE_MAP);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    // GL is only queried here, the decode may run on another thread
+    std::vector<GLint> formats = TextureStreamer::compressedFormats();
+    GLenum compressedFormat = std::find(formats.begin(), formats.end(), GL_COMPRESSED_RGB_S3TC_DXT1_EXT) != formats.end()
+        ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB;
+    auto decode = [faces, cachePath, formats, compressedFormat](StreamedImage& image) {
+        // the cache is used as long as it is newer than every face
+        if (cacheFresh(faces, cachePath) && readCache(cachePath, formats, image)) return true;
+        image = StreamedImage();
+        return decodeFaces(faces, compressedFormat, image);
+    };
+    // the faces were compressed by the driver on upload, keep its result for the next run
+    auto onResident = [cachePath, textureID](const StreamedImage& image) {
+        if (image.compressed) return;
+        int levels = 0;
+        for (const StreamedImage::Level& level : image.levels)
+            if (level.target == GL_TEXTURE_CUBE_MAP_POSITIVE_X) levels++;
+        writeCache(cachePath, textureID, image.levels[0].width, levels);
+    };
 
+    if (streamer) {
+        streamer->request({ textureID, GL_TEXTURE_CUBE_MAP }, decode, onResident);
+    } else {
+        StreamedImage image;
+        if (decode(image)) {
+            TextureStreamer::upload({ textureID, GL_TEXTURE_CUBE_MAP }, image);
+            onResident(image);
+        }
+    }
     return textureID;
 }
 
 void Skybox::draw(Shader shader, const glm::mat4& view, const glm::mat4& projection) {
     glDepthFunc(GL_LEQUAL);
     shader.use();
-    shader.setInt("skybox", 0);
-    shader.setMat4("view", glm::mat4(glm::mat3(view))); // Remove translation from view matrix
-    shader.setMat4("projection", projection);
+    shader.setInt("dayMap", 0);
+    shader.setInt("nightMap", 1);
+    shader.setFloat("night", night);
+    // Remove translation from view matrix, the fragment shader turns NDC back into a direction
+    shader.setMat4("inverseViewProjection", glm::inverse(projection * glm::mat4(glm::mat3(view))));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTextureMorning);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTextureEvening);
     glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(VAO);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, currentTexture);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    triangle.draw();
     glDepthFunc(GL_LESS);
 }
 
+void Skybox::setNight(float amount) {
+    night = glm::clamp(amount, 0.0f, 1.0f);
+}
+
 void Skybox::setEnvironment(bool isMorning) {
-    currentTexture = isMorning ? cubemapTextureMorning : cubemapTextureEvening;
+    setNight(isMorning ? 0.0f : 1.0f);
 }
@@ -24,6 +24,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 #include "Sphere.h"
 
 
@@ -43,6 +44,26 @@ Sphere::Sphere(float radius, int sectors, int stacks, bool smooth, int up) : int
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// build the same sphere at decreasing resolutions for LOD selection
+// level 0 is the given resolution, every next level halves sectors and stacks
+///////////////////////////////////////////////////////////////////////////////
+std::vector<Sphere> Sphere::buildLods(float radius, int sectors, int stacks, int levelCount, bool smooth, int up)
+{
+    std::vector<Sphere> lods;
+    for(int i = 0; i < levelCount; ++i)
+    {
+        lods.push_back(Sphere(radius, sectors, stacks, smooth, up));
+        if(sectors <= MIN_SECTOR_COUNT && stacks <= MIN_STACK_COUNT)
+            break;
+        sectors = std::max(sectors / 2, MIN_SECTOR_COUNT);
+        stacks = std::max(stacks / 2, MIN_STACK_COUNT);
+    }
+    return lods;
+}
+
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // setters
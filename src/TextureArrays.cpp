@@ -0,0 +1,408 @@
+#include "TextureArrays.h"
+#include "KTX2.h"
+#include "BlockCompression.h"
+#include <stb_image.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <tuple>
+
+TextureArrays::TextureArrays() : arrayCount(0), alphaChanged(false), memoryBudget(DEFAULT_MEMORY_BUDGET), memoryUsed(0), frame(0)
+{
+    for (int i = 0; i < MAX_ARRAYS; i++) arrays[i] = 0;
+}
+
+void TextureArrays::add(const std::string& path)
+{
+    for (const Image& image : images)
+        if (image.path == path) return;
+
+    Image image;
+    image.path = path;
+    image.slot = 0;
+    image.layer = 0;
+    image.alphaMode = ALPHA_OPAQUE;
+    image.format = GL_RGBA8;
+    image.id = 0;
+    int nrComponents;
+    // only the size (and format) is needed to pick the array, build() decodes the pixels
+    KTX2Texture cooked;
+    if (KTX2Texture::findCooked(path, true, cooked, true) && TextureStreamer::compressedFormatSupported(cooked.glFormat())) {
+        image.width = cooked.width;
+        image.height = cooked.height;
+        image.format = cooked.glFormat();
+        image.alphaMode = cooked.alphaMode();
+    } else if (!stbi_info(path.c_str(), &image.width, &image.height, &nrComponents)) {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        image.width = image.height = 0;
+    }
+    images.push_back(image);
+}
+
+// one 4x4 block of mid grey in a compressed format (BPTC stays zero, there is no encoder for it)
+static void greyBlock(GLenum format, unsigned char* block)
+{
+    unsigned char texels[16 * 4];
+    for (int i = 0; i < 16; i++) {
+        texels[i * 4] = texels[i * 4 + 1] = texels[i * 4 + 2] = 128;
+        texels[i * 4 + 3] = 255;
+    }
+    std::fill(block, block + 16, 0);
+    switch (format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: encodeBC1(texels, block); break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: encodeBC3(texels, block); break;
+    case GL_COMPRESSED_RED_RGTC1: encodeBC4(texels, 0, block); break;
+    case GL_COMPRESSED_RG_RGTC2: encodeBC5(texels, block); break;
+    }
+}
+
+// bytes of one layer of a mip level
+static size_t levelBytes(GLenum format, int width, int height)
+{
+    int blockBytes = KTX2Texture::glBlockBytes(format);
+    if (blockBytes) return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+    return (size_t)width * height * 4;
+}
+
+// (re)specifies the storage of one mip level, empty: a zero sized image that frees it
+static void specifyLevel(GLenum target, int level, GLenum format, int width, int height, int layers, bool empty)
+{
+    if (empty) width = height = layers = 0;
+    bool compressed = KTX2Texture::glBlockBytes(format) != 0;
+    GLsizei size = (GLsizei)(levelBytes(format, width, height) * layers);
+    if (compressed && target == GL_TEXTURE_2D_ARRAY)
+        glCompressedTexImage3D(target, level, format, width, height, layers, 0, size, nullptr);
+    else if (compressed)
+        glCompressedTexImage2D(target, level, format, width, height, 0, size, nullptr);
+    else if (target == GL_TEXTURE_2D_ARRAY)
+        glTexImage3D(target, level, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    else
+        glTexImage2D(target, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+}
+
+int TextureArrays::levelCount(int width, int height)
+{
+    int levels = 1;
+    while ((std::max(width, height) >> levels) > 0) levels++;
+    return levels;
+}
+
+void TextureArrays::allocate(GLenum target, GLuint texture, int width, int height, int layers, GLenum format, int firstLevel)
+{
+    glBindTexture(target, texture);
+    int levels = levelCount(width, height);
+    for (int level = firstLevel; level < levels; level++)
+        specifyLevel(target, level, format, std::max(1, width >> level), std::max(1, height >> level), layers, false);
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, firstLevel);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    int blockBytes = KTX2Texture::glBlockBytes(format);
+    if (blockBytes) {
+        // block formats can't be rendered to, every layer gets a level of grey blocks
+        unsigned char block[16];
+        greyBlock(format, block);
+        std::vector<unsigned char> grey;
+        for (int level = firstLevel; level < levels; level++) {
+            int levelWidth = std::max(1, width >> level), levelHeight = std::max(1, height >> level);
+            size_t blocks = (size_t)((levelWidth + 3) / 4) * ((levelHeight + 3) / 4);
+            grey.resize(blocks * blockBytes);
+            for (size_t b = 0; b < blocks; b++) std::copy(block, block + blockBytes, &grey[b * blockBytes]);
+            for (int layer = 0; layer < layers; layer++) {
+                if (target == GL_TEXTURE_2D_ARRAY)
+                    glCompressedTexSubImage3D(target, level, 0, 0, layer, levelWidth, levelHeight, 1, format, (GLsizei)grey.size(), grey.data());
+                else
+                    glCompressedTexSubImage2D(target, level, 0, 0, levelWidth, levelHeight, format, (GLsizei)grey.size(), grey.data());
+            }
+        }
+        return;
+    }
+
+    // placeholder grey, cleared on the GPU rather than uploaded
+    const GLfloat grey[4] = { 0.5f, 0.5f, 0.5f, 1.0f };
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    for (int level = firstLevel; level < levels; level++)
+        for (int layer = 0; layer < layers; layer++) {
+            if (target == GL_TEXTURE_2D_ARRAY)
+                glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, level, layer);
+            else
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, level);
+            glClearBufferfv(GL_COLOR, 0, grey);
+        }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+}
+
+int TextureArrays::coarseLevel(int width, int height)
+{
+    int level = 0;
+    while ((std::max(width, height) >> level) > RESIDENT_SIZE) level++;
+    return level;
+}
+
+void TextureArrays::build(TextureStreamer* streamer)
+{
+    // size classes (size and format) with the most layers get the arrays
+    std::map<std::tuple<int, int, GLenum>, int> layerCount;
+    for (const Image& image : images)
+        if (image.width > 0) layerCount[std::make_tuple(image.width, image.height, image.format)]++;
+    std::vector<std::pair<int, std::tuple<int, int, GLenum>>> sizeClasses;
+    for (auto& size : layerCount)
+        sizeClasses.push_back({ size.second, size.first });
+    std::stable_sort(sizeClasses.begin(), sizeClasses.end(), [](const std::pair<int, std::tuple<int, int, GLenum>>& a, const std::pair<int, std::tuple<int, int, GLenum>>& b) {
+        return a.first > b.first;
+    });
+
+    arrayCount = std::min((int)sizeClasses.size(), MAX_ARRAYS);
+    residency.clear();
+    memoryUsed = 0;
+
+    // arrays first, residency[slot - 1] is the unit of an array
+    for (int a = 0; a < arrayCount; a++)
+    {
+        Residency unit;
+        std::tie(unit.width, unit.height, unit.format) = sizeClasses[a].second;
+        glGenTextures(1, &arrays[a]);
+        unit.texture = arrays[a];
+        unit.target = GL_TEXTURE_2D_ARRAY;
+        for (size_t i = 0; i < images.size(); i++)
+            if (images[i].width == unit.width && images[i].height == unit.height && images[i].format == unit.format) {
+                images[i].slot = a + 1;
+                images[i].layer = (int)unit.images.size();
+                unit.images.push_back(i);
+            }
+        residency.push_back(unit);
+    }
+
+    // sizes that did not get an array stay plain textures
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        Image& image = images[i];
+        if (image.width == 0 || image.slot != 0) continue;
+        glGenTextures(1, &image.id);
+        leftovers.push_back(image.id);
+        Residency unit;
+        unit.texture = image.id;
+        unit.target = GL_TEXTURE_2D;
+        unit.width = image.width;
+        unit.height = image.height;
+        unit.format = image.format;
+        unit.images.push_back(i);
+        residency.push_back(unit);
+    }
+
+    for (size_t u = 0; u < residency.size(); u++)
+    {
+        Residency& unit = residency[u];
+        unit.levels = levelCount(unit.width, unit.height);
+        unit.coarseLevel = coarseLevel(unit.width, unit.height);
+        unit.residentLevel = unit.levels;
+        unit.requestedLevel = unit.neededLevel = unit.coarseLevel;
+        // the levels exist from here on, streaming only replaces contents
+        allocate(unit.target, unit.texture, unit.width, unit.height, (int)unit.images.size(), unit.format, unit.coarseLevel);
+        memoryUsed += residentBytes(unit, unit.coarseLevel);
+        glTexParameteri(unit.target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(unit.target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(unit.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(unit.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(unit.target, 0);
+    }
+
+    // pixels of the coarse levels (model images are flipped on load, like every texture of the scene)
+    for (size_t u = 0; u < residency.size(); u++)
+        loadLevels(u, residency[u].coarseLevel, streamer);
+}
+
+size_t TextureArrays::residentBytes(const Residency& unit, int firstLevel)
+{
+    size_t bytes = 0;
+    for (int level = firstLevel; level < unit.levels; level++)
+        bytes += levelBytes(unit.format, std::max(1, unit.width >> level), std::max(1, unit.height >> level)) * unit.images.size();
+    return bytes;
+}
+
+void TextureArrays::loadLevels(size_t unitIndex, int firstLevel, TextureStreamer* streamer)
+{
+    Residency& unit = residency[unitIndex];
+    int endLevel = unit.residentLevel;
+    unit.loadingLevel = firstLevel;
+    unit.layersPending = (int)unit.images.size();
+    for (size_t i : unit.images)
+    {
+        std::string path = images[i].path;
+        // the layer format is fixed now, so no switching between cooked and source later
+        bool cooked = images[i].format != GL_RGBA8;
+        GLenum format = unit.format;
+        int width = unit.width, height = unit.height;
+        auto decode = [path, cooked, format, width, height, firstLevel, endLevel](StreamedImage& decoded) {
+            if (cooked ? decoded.loadCooked(path, true) : decoded.loadSource(path, 4, true)) {
+                decoded.keepLevels(firstLevel, endLevel);
+                return true;
+            }
+            // black, but the layer still counts toward the level being resident
+            decoded = StreamedImage();
+            decoded.compressed = KTX2Texture::glBlockBytes(format) != 0;
+            decoded.internalFormat = format;
+            for (int level = firstLevel; level < endLevel; level++) {
+                int levelWidth = std::max(1, width >> level), levelHeight = std::max(1, height >> level);
+                size_t size = levelBytes(format, levelWidth, levelHeight);
+                decoded.levels.push_back({ GL_TEXTURE_2D, level, levelWidth, levelHeight, decoded.data.size(), size });
+                decoded.data.resize(decoded.data.size() + size, 0);
+            }
+            return true;
+        };
+        StreamDestination destination = { unit.texture, unit.target, images[i].layer, true };
+        auto onResident = [this, unitIndex, i](const StreamedImage& decoded) { onLevelsResident(unitIndex, i, decoded); };
+        if (streamer) {
+            streamer->request(destination, decode, onResident);
+        } else {
+            StreamedImage decoded;
+            decode(decoded);
+            TextureStreamer::upload(destination, decoded);
+            onResident(decoded);
+        }
+    }
+}
+
+void TextureArrays::onLevelsResident(size_t unitIndex, size_t imageIndex, const StreamedImage& decoded)
+{
+    // dropped by Delete() while streaming
+    if (unitIndex >= residency.size()) return;
+    Residency& unit = residency[unitIndex];
+    // the alpha class comes with the first (coarse) load
+    if (unit.residentLevel == unit.levels) onDecoded(imageIndex, decoded);
+    if (--unit.layersPending > 0) return;
+    // every layer has the new levels, let the sampler use them
+    unit.residentLevel = unit.loadingLevel;
+    glBindTexture(unit.target, unit.texture);
+    glTexParameteri(unit.target, GL_TEXTURE_BASE_LEVEL, unit.residentLevel);
+    glBindTexture(unit.target, 0);
+}
+
+void TextureArrays::requestDetail(const Texture& texture, float screenPixels)
+{
+    Residency* unit = nullptr;
+    if (texture.slot > 0 && texture.slot <= arrayCount) {
+        unit = &residency[texture.slot - 1];
+    } else if (texture.slot == 0 && texture.id != 0) {
+        for (size_t u = arrayCount; u < residency.size() && !unit; u++)
+            if (residency[u].texture == texture.id) unit = &residency[u];
+    }
+    if (!unit) return;
+
+    // about one texel per pixel: every halving of the footprint drops a level
+    float size = (float)std::max(unit->width, unit->height);
+    int level = screenPixels >= size ? 0 : (int)std::floor(std::log2(size / std::max(screenPixels, 1.0f)));
+    unit->requestedLevel = std::min(unit->requestedLevel, level);
+    unit->lastUse = frame;
+}
+
+bool TextureArrays::makeRoom(size_t bytes, size_t keep)
+{
+    while (memoryUsed + bytes > memoryBudget)
+    {
+        // least recently used unit holding more detail than it needs
+        Residency* victim = nullptr;
+        for (size_t u = 0; u < residency.size(); u++) {
+            Residency& unit = residency[u];
+            if (u == keep || unit.layersPending > 0 || unit.residentLevel >= unit.neededLevel) continue;
+            if (!victim || unit.lastUse < victim->lastUse) victim = &unit;
+        }
+        if (!victim) return false;
+
+        // the sampler leaves the levels first, then their storage goes
+        int level = victim->neededLevel;
+        memoryUsed -= residentBytes(*victim, victim->residentLevel) - residentBytes(*victim, level);
+        glBindTexture(victim->target, victim->texture);
+        glTexParameteri(victim->target, GL_TEXTURE_BASE_LEVEL, level);
+        for (int l = victim->residentLevel; l < level; l++)
+            specifyLevel(victim->target, l, victim->format, 0, 0, 0, true);
+        glBindTexture(victim->target, 0);
+        victim->residentLevel = level;
+    }
+    return true;
+}
+
+void TextureArrays::updateResidency(TextureStreamer* streamer)
+{
+    // the requests of the frame drawn last are what is needed now
+    for (Residency& unit : residency) {
+        unit.neededLevel = unit.requestedLevel;
+        unit.requestedLevel = unit.coarseLevel;
+    }
+    frame++;
+
+    for (size_t u = 0; u < residency.size(); u++)
+    {
+        Residency& unit = residency[u];
+        // one load at a time per unit, and only on top of the coarse levels
+        if (unit.layersPending > 0 || unit.neededLevel >= unit.residentLevel) continue;
+        // as much of the requested detail as the budget allows
+        int level = unit.neededLevel;
+        while (level < unit.residentLevel && !makeRoom(residentBytes(unit, level) - residentBytes(unit, unit.residentLevel), u)) level++;
+        if (level == unit.residentLevel) continue;
+
+        memoryUsed += residentBytes(unit, level) - residentBytes(unit, unit.residentLevel);
+        glBindTexture(unit.target, unit.texture);
+        for (int l = level; l < unit.residentLevel; l++)
+            specifyLevel(unit.target, l, unit.format, std::max(1, unit.width >> l), std::max(1, unit.height >> l), (int)unit.images.size(), false);
+        glBindTexture(unit.target, 0);
+        loadLevels(u, level, streamer);
+    }
+}
+
+void TextureArrays::onDecoded(size_t index, const StreamedImage& decoded)
+{
+    // dropped by Delete() while streaming
+    if (index >= images.size()) return;
+    images[index].alphaMode = decoded.alphaMode;
+    if (decoded.alphaMode != ALPHA_OPAQUE) alphaChanged = true;
+}
+
+bool TextureArrays::takeAlphaChanges()
+{
+    bool changed = alphaChanged;
+    alphaChanged = false;
+    return changed;
+}
+
+void TextureArrays::resolve(Texture& texture, const std::string& directory) const
+{
+    std::string path = directory + '/' + texture.path;
+    for (const Image& image : images)
+        if (image.path == path) {
+            texture.id = image.id;
+            texture.slot = image.slot;
+            texture.layer = image.layer;
+            texture.alphaMode = image.alphaMode;
+            return;
+        }
+}
+
+void TextureArrays::bind(Shader& shader) const
+{
+    // unused samplers still get their own unit, a unit may not mix sampler types
+    char name[32];
+    for (int a = 0; a < MAX_ARRAYS; a++) {
+        glActiveTexture(GL_TEXTURE0 + FIRST_UNIT + a);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[a]);
+        snprintf(name, sizeof(name), "textureArray%d", a);
+        shader.setInt(name, FIRST_UNIT + a);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void TextureArrays::Delete()
+{
+    glDeleteTextures(arrayCount, arrays);
+    if (!leftovers.empty()) glDeleteTextures((GLsizei)leftovers.size(), leftovers.data());
+    arrayCount = 0;
+    leftovers.clear();
+    images.clear();
+    residency.clear();
+    memoryUsed = 0;
+}
@@ -0,0 +1,207 @@
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+namespace
+{
+    struct CacheEntry
+    {
+        int references;
+        int alphaMode;
+        // every key that leads here, dropped with the texture
+        std::vector<std::string> keys;
+        // for hashing once another texture's files have the same sizes
+        std::vector<std::string> files;
+        std::string sizeKey;
+        bool hashed;
+    };
+
+    // keys: "path:" canonical paths or "hash:" content hash, both followed by the variant
+    std::unordered_map<std::string, GLuint>& keys()
+    {
+        static std::unordered_map<std::string, GLuint> map;
+        return map;
+    }
+
+    std::unordered_map<GLuint, CacheEntry>& entries()
+    {
+        static std::unordered_map<GLuint, CacheEntry> map;
+        return map;
+    }
+
+    // file sizes and variant -> the textures loaded from files of those sizes
+    std::unordered_multimap<std::string, GLuint>& sizes()
+    {
+        static std::unordered_multimap<std::string, GLuint> map;
+        return map;
+    }
+
+    std::string pathKey(const std::vector<std::string>& files, const std::string& variant)
+    {
+        std::string key = "path:";
+        for (const std::string& file : files) {
+            std::error_code error;
+            std::filesystem::path canonical = std::filesystem::weakly_canonical(file, error);
+            key += (error ? file : canonical.string()) + '|';
+        }
+        return key + variant;
+    }
+
+    // empty if a file can't be read
+    std::string sizeKey(const std::vector<std::string>& files, const std::string& variant)
+    {
+        std::string key;
+        for (const std::string& file : files) {
+            std::error_code error;
+            uintmax_t size = std::filesystem::file_size(file, error);
+            if (error) return "";
+            key += std::to_string(size) + '|';
+        }
+        return key + variant;
+    }
+
+    std::string hashKey(uint64_t hash, const std::string& variant)
+    {
+        return "hash:" + std::to_string(hash) + '|' + variant;
+    }
+
+    // adds the "hash:" key of a texture cached without one
+    void addHashKey(GLuint texture, CacheEntry& entry, const std::string& variant)
+    {
+        if (entry.hashed) return;
+        entry.hashed = true;
+        uint64_t hash = TextureCache::contentHash(entry.files);
+        if (!hash) return;
+        std::string key = hashKey(hash, variant);
+        // an equal texture cached before keeps the key
+        if (keys().emplace(key, texture).second) entry.keys.push_back(key);
+    }
+}
+
+GLuint TextureCache::acquire(const std::vector<std::string>& files, const std::string& variant,
+                             const std::function<GLuint(int& alphaMode)>& load, int* alphaMode, bool* created)
+{
+    auto found = [&](GLuint texture) {
+        CacheEntry& entry = entries()[texture];
+        entry.references++;
+        if (alphaMode) *alphaMode = entry.alphaMode;
+        if (created) *created = false;
+        return texture;
+    };
+
+    // the same files under the same names, no need to read them
+    std::string byPath = pathKey(files, variant);
+    auto path = keys().find(byPath);
+    if (path != keys().end()) return found(path->second);
+
+    // the same contents under another name (only possible with the same sizes): remember the name too
+    std::string bySize = sizeKey(files, variant);
+    uint64_t hash = 0;
+    if (!bySize.empty() && sizes().count(bySize)) {
+        auto candidates = sizes().equal_range(bySize);
+        for (auto candidate = candidates.first; candidate != candidates.second; ++candidate)
+            addHashKey(candidate->second, entries()[candidate->second], variant);
+        hash = contentHash(files);
+        auto content = hash ? keys().find(hashKey(hash, variant)) : keys().end();
+        if (content != keys().end()) {
+            keys()[byPath] = content->second;
+            entries()[content->second].keys.push_back(byPath);
+            return found(content->second);
+        }
+    }
+
+    int mode = ALPHA_OPAQUE;
+    GLuint texture = load(mode);
+    CacheEntry& entry = entries()[texture];
+    entry.references = 1;
+    entry.alphaMode = mode;
+    entry.keys.push_back(byPath);
+    entry.files = files;
+    entry.sizeKey = bySize;
+    entry.hashed = false;
+    keys()[byPath] = texture;
+    if (hash) {
+        entry.hashed = true;
+        std::string byHash = hashKey(hash, variant);
+        entry.keys.push_back(byHash);
+        keys()[byHash] = texture;
+    }
+    if (!bySize.empty()) sizes().emplace(bySize, texture);
+    if (alphaMode) *alphaMode = mode;
+    if (created) *created = true;
+    return texture;
+}
+
+GLuint TextureCache::acquire2D(const std::string& path, int channels, bool flip, TextureStreamer* streamer, int* alphaMode, bool* created)
+{
+    std::string variant = "2D:" + std::to_string(channels) + (flip ? ":flip" : "");
+    return acquire({ path }, variant, [&](int& mode) {
+        GLuint texture;
+        if (streamer) {
+            // the material is fixed before the pixels arrive, so go by the header
+            mode = TextureStreamer::headerAlphaMode(path);
+            texture = streamer->load2D(path, channels, flip);
+        } else {
+            StreamedImage image;
+            glGenTextures(1, &texture);
+            if (image.loadFile(path, channels, flip)) {
+                mode = image.alphaMode;
+                TextureStreamer::upload({ texture, GL_TEXTURE_2D }, image);
+            }
+        }
+        return texture;
+    }, alphaMode, created);
+}
+
+void TextureCache::retain(GLuint texture)
+{
+    auto entry = entries().find(texture);
+    if (entry != entries().end()) entry->second.references++;
+}
+
+void TextureCache::release(GLuint texture)
+{
+    auto entry = entries().find(texture);
+    if (entry != entries().end()) {
+        if (--entry->second.references > 0) return;
+        for (const std::string& key : entry->second.keys) keys().erase(key);
+        auto sized = sizes().equal_range(entry->second.sizeKey);
+        for (auto it = sized.first; it != sized.second; ++it)
+            if (it->second == texture) {
+                sizes().erase(it);
+                break;
+            }
+        entries().erase(entry);
+    }
+    glDeleteTextures(1, &texture);
+}
+
+int TextureCache::references(GLuint texture)
+{
+    auto entry = entries().find(texture);
+    return entry != entries().end() ? entry->second.references : 0;
+}
+
+uint64_t TextureCache::contentHash(const std::vector<std::string>& files)
+{
+    uint64_t hash = 14695981039346656037ull;
+    std::vector<char> buffer(1 << 16);
+    for (const std::string& path : files) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return 0;
+        while (file) {
+            file.read(buffer.data(), buffer.size());
+            std::streamsize count = file.gcount();
+            for (std::streamsize i = 0; i < count; i++) {
+                hash ^= (unsigned char)buffer[i];
+                hash *= 1099511628211ull;
+            }
+        }
+        // file boundary, so moved bytes between faces change the hash
+        hash ^= 0xFF;
+        hash *= 1099511628211ull;
+    }
+    return hash ? hash : 1;
+}
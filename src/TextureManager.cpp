@@ -1,22 +1,23 @@
 #include"TextureManager.h"
 
-TextureManager::TextureManager(){}
+TextureManager::TextureManager() : alphaMode(ALPHA_OPAQUE) {}
 
-TextureManager::TextureManager(const char* image, GLenum texType, GLenum slot, GLenum format, GLenum pixelType)
+TextureManager::TextureManager(const char* image, GLenum texType, GLenum slot, GLenum format, GLenum pixelType, TextureStreamer* streamer)
 {
 	// Assigns the type of the texture ot the texture object
         type = texType;
         texSlot = slot;
 
-        // Stores the width, height, and the number of color channels of the image
-        int widthImg, heightImg, numColCh;
-        // Flips the image so it appears right side up
+        // Decodes to the channel count of format (same orientation as the models),
+        // an image another loader already has comes back from the cache
+        int channels = format == GL_RED ? 1 : (format == GL_RG ? 2 : (format == GL_RGB ? 3 : 4));
+        int mode;
+        bool created;
+        ID = TextureCache::acquire2D(image, channels, true, streamer, &mode, &created);
+        alphaMode = (AlphaMode)mode;
+        // the sampler state belongs to whoever loaded it first
+        if (!created) return;
 
-        // Reads the image from a file and stores it in bytes
-        unsigned char* bytes = stbi_load(image, &widthImg, &heightImg, &numColCh, 0);
-
-        // Generates an OpenGL texture object
-        glGenTextures(1, &ID);
         // Assigns the texture to a TextureManager Unit
         glActiveTexture(slot);
         glBindTexture(texType, ID);
@@ -34,17 +35,6 @@ TextureManager::TextureManager(const char* image, GLenum texType, GLenum slot, G
         // float flatColor[] = {1.0f, 1.0f, 1.0f, 1.0f};
         // glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, flatColor);
 
-        // Assigns the image to the OpenGL Texture object
-        if(bytes){
-            glTexImage2D(texType, 0, GL_RGBA, widthImg, heightImg, 0, format, pixelType, bytes);
-            // Generates MipMaps
-            glGenerateMipmap(texType);
-        }
-        else std::cout << "Failed to load texture " << image << std::endl;
-
-        // Deletes the image data as it is already in the OpenGL Texture object
-        stbi_image_free(bytes);
-
         // Unbinds the OpenGL Texture object so that it can't accidentally be modified
         glBindTexture(texType, 0);
 }
@@ -71,15 +61,12 @@ void TextureManager::Unbind()
 
 void TextureManager::Delete()
 {
-	glDeleteTextures(1, &ID);
+	TextureCache::release(ID);
 }
 
-void TextureManager::enable(Shader mainShader, TextureManager diffuseTex, TextureManager specularTex, float textureCnt)
+void TextureManager::enable(TextureManager diffuseTex, TextureManager specularTex, int material)
 {
     diffuseTex.Bind();
     specularTex.Bind();
-    diffuseTex.texUnit(mainShader, "texture.diffuse1", 0);
-    specularTex.texUnit(mainShader, "texture.specular1", 1);
-    mainShader.setFloat("textureCnt", textureCnt);
-
+    glVertexAttribI1i(MATERIAL_LOCATION, material);
 }
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "TextureStreamer.h"
+#include "MipChain.h"
+#include "KTX2.h"
+#include <stb_image.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const GLenum pixelFormats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+static const GLenum internalFormats[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+
+bool StreamedImage::loadFile(const std::string& path, int channels, bool flip)
+{
+    return loadCooked(path, flip) || loadSource(path, channels, flip);
+}
+
+bool StreamedImage::loadCooked(const std::string& path, bool flip)
+{
+    KTX2Texture cooked;
+    if (!KTX2Texture::findCooked(path, flip, cooked) || !TextureStreamer::compressedFormatSupported(cooked.glFormat()))
+        return false;
+    compressed = true;
+    internalFormat = cooked.glFormat();
+    alphaMode = cooked.alphaMode();
+    for (int level = 0; level < cooked.levelCount; level++) {
+        levels.push_back({ GL_TEXTURE_2D, level, std::max(1, cooked.width >> level), std::max(1, cooked.height >> level),
+                           data.size(), cooked.levels[level].size() });
+        data.insert(data.end(), cooked.levels[level].begin(), cooked.levels[level].end());
+    }
+    return true;
+}
+
+bool StreamedImage::loadSource(const std::string& path, int channels, bool flip)
+{
+    // the flip flag is per thread, workers decode for different callers
+    stbi_set_flip_vertically_on_load_thread(flip);
+    int width, height, stored;
+    unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &stored, channels);
+    if (!pixels) {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return false;
+    }
+    int used = channels ? channels : stored;
+    alphaMode = classifyAlpha(pixels, width, height, used);
+    internalFormat = internalFormats[used - 1];
+    addMips(pixels, width, height, used, GL_TEXTURE_2D);
+    stbi_image_free(pixels);
+    return true;
+}
+
+void StreamedImage::addMips(const unsigned char* pixels, int width, int height, int channels, GLenum target)
+{
+    format = pixelFormats[channels - 1];
+    std::vector<unsigned char> current(pixels, pixels + (size_t)width * height * channels), next;
+    data.reserve(data.size() + current.size() * 4 / 3 + 64);
+    for (int level = 0; ; level++) {
+        levels.push_back({ target, level, width, height, data.size(), current.size() });
+        data.insert(data.end(), current.begin(), current.end());
+        if (width == 1 && height == 1) break;
+        halveImage(current, width, height, channels, next);
+        current.swap(next);
+    }
+}
+
+void StreamedImage::keepLevels(int first, int end)
+{
+    std::vector<unsigned char> kept;
+    std::vector<Level> keptLevels;
+    for (Level level : levels) {
+        if (level.level < first || level.level >= end) continue;
+        kept.insert(kept.end(), data.begin() + level.offset, data.begin() + level.offset + level.size);
+        level.offset = kept.size() - level.size;
+        keptLevels.push_back(level);
+    }
+    data.swap(kept);
+    levels.swap(keptLevels);
+}
+
+TextureStreamer::TextureStreamer() : uploads(nullptr), stopping(false), inFlight(0), nextBuffer(0)
+{
+    for (RingBuffer& slot : ring) {
+        glGenBuffers(1, &slot.buffer);
+        slot.capacity = 0;
+        slot.fence = 0;
+    }
+    // the decode jobs only read the list
+    compressedFormats();
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    // queued decodes see this and skip the work
+    stopping = true;
+    JobSystem::shared().wait(decoding);
+    JobSystem::shared().wait(uploading);
+}
+
+void TextureStreamer::request(const StreamDestination& destination, std::function<bool(StreamedImage&)> decode,
+                              std::function<void(const StreamedImage&)> onResident)
+{
+    std::unique_ptr<Job> job(new Job());
+    job->destination = destination;
+    job->decode = std::move(decode);
+    job->onResident = std::move(onResident);
+    job->decoded = false;
+    inFlight++;
+    Job* pending = job.release();
+    JobSystem::shared().run([this, pending] {
+        std::unique_ptr<Job> job(pending);
+        if (stopping) return;
+        job->decoded = job->decode(job->image);
+        // straight into the texture on the upload context, failures still go through update()
+        UploadThread* uploader = uploads.load();
+        if (uploader && job->decoded && !job->image.levels.empty()) {
+            std::shared_ptr<Job> uploaded(std::move(job));
+            uploader->upload([uploaded] {
+                upload(uploaded->destination, uploaded->image);
+            }, [this, uploaded] {
+                inFlight--;
+                if (uploaded->onResident && !stopping) uploaded->onResident(uploaded->image);
+            }, &uploading);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        decoded.push_back(std::move(job));
+    }, &decoding, JobPriority::Background);
+}
+
+GLuint TextureStreamer::load2D(const std::string& path, int channels, bool flip, std::function<void(const StreamedImage&)> onResident)
+{
+    GLuint texture = createPlaceholder(GL_TEXTURE_2D);
+    request({ texture, GL_TEXTURE_2D }, [path, channels, flip](StreamedImage& image) {
+        return image.loadFile(path, channels, flip);
+    }, std::move(onResident));
+    return texture;
+}
+
+void TextureStreamer::update()
+{
+    size_t uploaded = 0;
+    while (uploaded < FRAME_BUDGET) {
+        std::unique_ptr<Job> job;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (decoded.empty()) break;
+            job = std::move(decoded.front());
+            decoded.pop_front();
+        }
+        // a failed decode keeps its placeholder
+        if (!job->decoded || job->image.levels.empty()) {
+            inFlight--;
+            continue;
+        }
+
+        RingBuffer& slot = ring[nextBuffer];
+        if (slot.fence) {
+            // the GPU is still reading the oldest buffer, the ring is full for this frame
+            if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+                std::lock_guard<std::mutex> lock(mutex);
+                decoded.push_front(std::move(job));
+                break;
+            }
+            glDeleteSync(slot.fence);
+            slot.fence = 0;
+        }
+
+        size_t size = job->image.byteSize();
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+        if (slot.capacity < size) {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            slot.capacity = size;
+        }
+        // no implicit sync needed, the fence above guarantees the buffer is free
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        bool copied = false;
+        if (mapped) {
+            std::memcpy(mapped, job->image.data.data(), size);
+            copied = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+        }
+        if (copied) {
+            upload(job->destination, job->image, true);
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            nextBuffer = (nextBuffer + 1) % RING_SIZE;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        } else {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            upload(job->destination, job->image, false);
+        }
+        uploaded += size;
+        inFlight--;
+        if (job->onResident) job->onResident(job->image);
+    }
+}
+
+int TextureStreamer::pending() const
+{
+    return inFlight;
+}
+
+void TextureStreamer::upload(const StreamDestination& destination, const StreamedImage& image, bool fromUnpackBuffer)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(destination.target, destination.texture);
+    int maxLevel = 0;
+    for (const StreamedImage::Level& level : image.levels)
+    {
+        const void* source = fromUnpackBuffer ? (const void*)level.offset : (const void*)(image.data.data() + level.offset);
+        if (destination.target == GL_TEXTURE_2D_ARRAY && image.compressed)
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level.level, 0, 0, destination.layer, level.width, level.height, 1, image.internalFormat, (GLsizei)level.size, source);
+        else if (destination.target == GL_TEXTURE_2D_ARRAY)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level.level, 0, 0, destination.layer, level.width, level.height, 1, image.format, GL_UNSIGNED_BYTE, source);
+        else if (image.compressed && destination.allocated)
+            glCompressedTexSubImage2D(level.target, level.level, 0, 0, level.width, level.height, image.internalFormat, (GLsizei)level.size, source);
+        else if (image.compressed)
+            glCompressedTexImage2D(level.target, level.level, image.internalFormat, level.width, level.height, 0, (GLsizei)level.size, source);
+        else if (destination.allocated)
+            glTexSubImage2D(level.target, level.level, 0, 0, level.width, level.height, image.format, GL_UNSIGNED_BYTE, source);
+        else
+            glTexImage2D(level.target, level.level, image.internalFormat, level.width, level.height, 0, image.format, GL_UNSIGNED_BYTE, source);
+        maxLevel = std::max(maxLevel, level.level);
+    }
+    if (!destination.allocated)
+        glTexParameteri(destination.target, GL_TEXTURE_MAX_LEVEL, maxLevel);
+    glBindTexture(destination.target, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+GLuint TextureStreamer::createPlaceholder(GLenum target)
+{
+    const unsigned char grey[4] = { 128, 128, 128, 255 };
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(target, texture);
+    if (target == GL_TEXTURE_CUBE_MAP) {
+        for (int face = 0; face < 6; face++)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    } else {
+        glTexImage2D(target, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    }
+    // complete with any min filter until the real levels arrive
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(target, 0);
+    return texture;
+}
+
+AlphaMode TextureStreamer::headerAlphaMode(const std::string& path)
+{
+    KTX2Texture cooked;
+    if (KTX2Texture::findCooked(path, true, cooked, true) && compressedFormatSupported(cooked.glFormat()))
+        return cooked.alphaMode();
+    int width, height, channels;
+    if (!stbi_info(path.c_str(), &width, &height, &channels)) return ALPHA_OPAQUE;
+    return channels == 2 || channels == 4 ? ALPHA_CUTOUT : ALPHA_OPAQUE;
+}
+
+const std::vector<GLint>& TextureStreamer::compressedFormats()
+{
+    static const std::vector<GLint> formats = [] {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+        std::vector<GLint> list(count);
+        if (count > 0) glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, list.data());
+        return list;
+    }();
+    return formats;
+}
+
+bool TextureStreamer::compressedFormatSupported(GLenum format)
+{
+    // RGTC is core since GL 3.0 but not listed among the general purpose formats
+    if (format == GL_COMPRESSED_RED_RGTC1 || format == GL_COMPRESSED_RG_RGTC2) return true;
+    const std::vector<GLint>& formats = compressedFormats();
+    return format != 0 && std::find(formats.begin(), formats.end(), (GLint)format) != formats.end();
+}
+
+void TextureStreamer::Delete()
+{
+    for (RingBuffer& slot : ring) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        glDeleteBuffers(1, &slot.buffer);
+        slot.fence = 0;
+        slot.capacity = 0;
+    }
+}
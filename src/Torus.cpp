@@ -29,6 +29,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 #include "Torus.h"
 
 
@@ -48,6 +49,27 @@ Torus::Torus(float majorR, float minorR, int sectors, int sides, bool smooth, in
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// build the same torus at decreasing resolutions for LOD selection
+// level 0 is the given resolution, every next level halves sectors and sides
+///////////////////////////////////////////////////////////////////////////////
+std::vector<Torus> Torus::buildLods(float majorR, float minorR, int sectors, int sides,
+                                    int levelCount, bool smooth, int up)
+{
+    std::vector<Torus> lods;
+    for(int i = 0; i < levelCount; ++i)
+    {
+        lods.push_back(Torus(majorR, minorR, sectors, sides, smooth, up));
+        if(sectors <= MIN_SECTOR_COUNT && sides <= MIN_SIDE_COUNT)
+            break;
+        sectors = std::max(sectors / 2, MIN_SECTOR_COUNT);
+        sides = std::max(sides / 2, MIN_SIDE_COUNT);
+    }
+    return lods;
+}
+
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // setters
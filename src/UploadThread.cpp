@@ -0,0 +1,56 @@
+#include "UploadThread.h"
+
+UploadThread::UploadThread(GLFWwindow* window, JobSystem& jobs) : window(window), jobs(jobs), stopping(false)
+{
+	thread = std::thread(&UploadThread::run, this);
+}
+
+UploadThread::~UploadThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void UploadThread::upload(std::function<void()> work, std::function<void()> ready, JobCounter* counter)
+{
+	if (counter) jobs.hold(*counter);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queued.push_back({ std::move(work), std::move(ready), counter });
+	}
+	wake.notify_one();
+}
+
+void UploadThread::run()
+{
+	glfwMakeContextCurrent(window);
+	while (true) {
+		Upload upload;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return stopping || !queued.empty(); });
+			if (queued.empty()) break;
+			upload = std::move(queued.front());
+			queued.pop_front();
+		}
+		if (upload.work) upload.work();
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		// the other context can only wait for a fence that reached the GPU
+		glFlush();
+		// ready may run after this object is gone
+		JobSystem* system = &jobs;
+		std::function<void()> ready = std::move(upload.ready);
+		JobCounter* counter = upload.counter;
+		jobs.runOnGLThread([system, fence, ready, counter] {
+			glWaitSync(fence, 0, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fence);
+			if (ready) ready();
+			if (counter) system->release(*counter);
+		});
+	}
+	glfwMakeContextCurrent(nullptr);
+}
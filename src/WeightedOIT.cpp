@@ -0,0 +1,82 @@
+#include "WeightedOIT.h"
+#include <iostream>
+
+static GLuint createTarget(GLenum internalFormat, GLenum format, unsigned int width, unsigned int height)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_FLOAT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+WeightedOIT::WeightedOIT() : FBO(0), accum(0), revealage(0), depthRBO(0), width(0), height(0) {}
+
+WeightedOIT::WeightedOIT(unsigned int width, unsigned int height) : width(width), height(height)
+{
+	accum = createTarget(GL_RGBA16F, GL_RGBA, width, height);
+	revealage = createTarget(GL_R16F, GL_RED, width, height);
+	// same format as the default framebuffer's depth so it can be blitted
+	glGenRenderbuffers(1, &depthRBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+	glGenFramebuffers(1, &FBO);
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accum, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, revealage, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+	unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, attachments);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::OIT:: framebuffer is not complete" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void WeightedOIT::begin(GLuint sceneFBO, unsigned int viewWidth, unsigned int viewHeight)
+{
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+	glBlitFramebuffer(0, 0, viewWidth, viewHeight, 0, 0, viewWidth, viewHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+	glViewport(0, 0, viewWidth, viewHeight);
+	// zero is the neutral value of both sums
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	// both faces of a translucent surface contribute
+	glDisable(GL_CULL_FACE);
+}
+
+void WeightedOIT::end(GLuint sceneFBO)
+{
+	glEnable(GL_CULL_FACE);
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+}
+
+void WeightedOIT::bindTextures(GLuint firstUnit)
+{
+	glActiveTexture(GL_TEXTURE0 + firstUnit);
+	glBindTexture(GL_TEXTURE_2D, accum);
+	glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+	glBindTexture(GL_TEXTURE_2D, revealage);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void WeightedOIT::Delete()
+{
+	glDeleteFramebuffers(1, &FBO);
+	glDeleteTextures(1, &accum);
+	glDeleteTextures(1, &revealage);
+	glDeleteRenderbuffers(1, &depthRBO);
+}
@@ -2,16 +2,49 @@
 #include <GLFW/glfw3.h>
 
 #include "Controller.h"
-#include "App/Renderer.h"
+#include "App/RenderThread.h"
+#include "FrameScheduler.h"
+#include "AllocationCounter.h"
 
 #include <irrKlang.h>
+#include <cassert>
+#include <cstdlib>
 
 using namespace irrklang;
 
 using namespace std;
 
-int main()
+int main(int argc, char** argv)
 {
+    //render path and anti-aliasing are picked once at startup: ./app --deferred --taa
+    RenderPath renderPath = RenderPath::Forward;
+    AntiAliasing antiAliasing = AntiAliasing::FXAA;
+    //render on demand (kiosk/monitor displays): ./app --on-demand --min-refresh 0.2
+    //only draws when something changed, otherwise re-presents at least min-refresh times a second
+    bool onDemand = false;
+    double minRefresh = 1.0;
+    //timing: simulation ticks per second, vsync, optional frame rate cap: ./app --tick-rate 120 --no-vsync --fps-cap 90
+    double tickRate = 60.0, fpsCap = 0.0;
+    int swapInterval = 1;
+    //big buffer and texture uploads on a second, shared context unless: ./app --no-upload-thread
+    bool uploadThread = true;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--on-demand") onDemand = true;
+        else if (arg == "--min-refresh" && i + 1 < argc) minRefresh = atof(argv[++i]);
+        else if (arg == "--tick-rate" && i + 1 < argc) tickRate = glm::max(atof(argv[++i]), 1.0);
+        else if (arg == "--fps-cap" && i + 1 < argc) fpsCap = atof(argv[++i]);
+        else if (arg == "--no-vsync") swapInterval = 0;
+        else if (arg == "--no-upload-thread") uploadThread = false;
+        else if (arg == "--deferred") renderPath = RenderPath::Deferred;
+        else if (arg == "--no-aa") antiAliasing = AntiAliasing::None;
+        else if (arg == "--fxaa") antiAliasing = AntiAliasing::FXAA;
+        else if (arg == "--taa") antiAliasing = AntiAliasing::TAA;
+        else if (arg == "--msaa") antiAliasing = AntiAliasing::MSAA;
+    }
+
+
     //Controller:
     Controller controller;
     if (!controller.initializeWindow("Learning CG")) return -1;
@@ -20,21 +53,48 @@ int main()
     ISoundEngine *SoundEngine = createIrrKlangDevice();
     SoundEngine->play2D("../resources/audio/song.ogg", true);
     
-    //Renderer:
-    Renderer renderer;
+    //Renderer, on its own thread with the context (this one polls events and simulates):
+    GLFWwindow* uploadContext = uploadThread ? controller.createUploadContext() : nullptr;
+    glfwMakeContextCurrent(nullptr);
+    RenderThread renderThread(controller.getWindow(), { renderPath, antiAliasing, swapInterval, onDemand, minRefresh, uploadContext });
     
-    // render loop:
+    // main loop:
+    FrameScheduler scheduler(tickRate, fpsCap);
     while(!controller.shouldClose()){
         controller.updateDeltaTime();
         controller.processInput();
+        // simulation at a fixed tick whatever the frame took, drawn in between the last two
+        for (int ticks = scheduler.beginFrame(); ticks > 0; ticks--)
+            controller.tick((float)scheduler.tickSeconds());
+        controller.setInterpolation(scheduler.alpha());
+
+        // hand the frame over, the render thread may still be drawing the last one
+        // (without instance or light updates it takes no heap memory)
+        size_t allocations = AllocationCounter::thisThread();
+        FrameInput input;
+        input.camera = controller.getRenderCamera();
+        input.isNight = controller.isNight;
+        input.deltaTime = controller.getDeltaTime();
+        glfwGetFramebufferSize(controller.getWindow(), &input.framebufferWidth, &input.framebufferHeight);
+        input.windowChanged = controller.windowChanged;
+        controller.windowChanged = false;
+        renderThread.submit(std::move(input));
+        assert(AllocationCounter::thisThread() == allocations);
 
-        // render
-        renderer.render(controller);
-        
-        glfwSwapBuffers(controller.getWindow());
+        // a held movement key changes the camera on the coming ticks, so keep going
+        if (onDemand && renderThread.isIdle() && !controller.isMoving()) {
+            // nothing changed: sleep until input arrives, the refresh is due or the render thread got GL work
+            glfwWaitEventsTimeout(minRefresh > 0.0 ? 1.0 / minRefresh : 1e9);
+            controller.resetDeltaTime();
+            scheduler.reset();
+            continue;
+        }
+        // pacing: sleep before polling, so the next frame starts from fresh input
+        scheduler.waitForDeadline();
         glfwPollEvents();
     }
 
+    renderThread.stop();
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
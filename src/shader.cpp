@@ -4,6 +4,24 @@
 // ------------------------------------------------------------------------
 Shader::Shader(){}
 Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath)
+{
+    load(vertexPath, fragmentPath, geometryPath, "");
+}
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::string& defines, const char* geometryPath)
+{
+    load(vertexPath, fragmentPath, geometryPath, defines);
+}
+// inserts the defines right after the #version line
+static std::string addDefines(const std::string& code, const std::string& defines)
+{
+    if(defines.empty())
+        return code;
+    std::size_t lineEnd = code.find('\n');
+    if(lineEnd == std::string::npos)
+        return code + "\n" + defines;
+    return code.substr(0, lineEnd + 1) + defines + "\n" + code.substr(lineEnd + 1);
+}
+void Shader::load(const char* vertexPath, const char* fragmentPath, const char* geometryPath, const std::string& defines)
 {
     // 1. retrieve the vertex/fragment source code from filePath
     std::string vertexCode;
@@ -29,8 +47,8 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geo
         vShaderFile.close();
         fShaderFile.close();
         // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();			
+        vertexCode = addDefines(vShaderStream.str(), defines);
+        fragmentCode = addDefines(fShaderStream.str(), defines);
         // if geometry shader path is present, also load a geometry shader
         if(geometryPath != nullptr)
         {
@@ -38,7 +56,7 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geo
             std::stringstream gShaderStream;
             gShaderStream << gShaderFile.rdbuf();
             gShaderFile.close();
-            geometryCode = gShaderStream.str();
+            geometryCode = addDefines(gShaderStream.str(), defines);
         }
     }
     catch (std::ifstream::failure& e)
@@ -92,61 +110,61 @@ void Shader::use()
 }
 // utility uniform functions
 // ------------------------------------------------------------------------
-void Shader::setBool(const std::string &name, bool value) const
+void Shader::setBool(const char* name, bool value) const
 {         
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+    glUniform1i(glGetUniformLocation(ID, name), (int)value); 
 }
 // ------------------------------------------------------------------------
-void Shader::setInt(const std::string &name, int value) const
+void Shader::setInt(const char* name, int value) const
 { 
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+    glUniform1i(glGetUniformLocation(ID, name), value); 
 }
 // ------------------------------------------------------------------------
-void Shader::setFloat(const std::string &name, float value) const
+void Shader::setFloat(const char* name, float value) const
 { 
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+    glUniform1f(glGetUniformLocation(ID, name), value); 
 }
 // ------------------------------------------------------------------------
-void Shader::setVec2(const std::string &name, const glm::vec2 &value) const
+void Shader::setVec2(const char* name, const glm::vec2 &value) const
 { 
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    glUniform2fv(glGetUniformLocation(ID, name), 1, &value[0]); 
 }
-void Shader::setVec2(const std::string &name, float x, float y) const
+void Shader::setVec2(const char* name, float x, float y) const
 { 
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+    glUniform2f(glGetUniformLocation(ID, name), x, y); 
 }
 // ------------------------------------------------------------------------
-void Shader::setVec3(const std::string &name, const glm::vec3 &value) const
+void Shader::setVec3(const char* name, const glm::vec3 &value) const
 { 
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    glUniform3fv(glGetUniformLocation(ID, name), 1, &value[0]); 
 }
-void Shader::setVec3(const std::string &name, float x, float y, float z) const
+void Shader::setVec3(const char* name, float x, float y, float z) const
 { 
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+    glUniform3f(glGetUniformLocation(ID, name), x, y, z); 
 }
 // ------------------------------------------------------------------------
-void Shader::setVec4(const std::string &name, const glm::vec4 &value) const
+void Shader::setVec4(const char* name, const glm::vec4 &value) const
 { 
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+    glUniform4fv(glGetUniformLocation(ID, name), 1, &value[0]); 
 }
-void Shader::setVec4(const std::string &name, float x, float y, float z, float w) const
+void Shader::setVec4(const char* name, float x, float y, float z, float w) const
 { 
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+    glUniform4f(glGetUniformLocation(ID, name), x, y, z, w); 
 }
 // ------------------------------------------------------------------------
-void Shader::setMat2(const std::string &name, const glm::mat2 &mat) const
+void Shader::setMat2(const char* name, const glm::mat2 &mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix2fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
 }
 // ------------------------------------------------------------------------
-void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const
+void Shader::setMat3(const char* name, const glm::mat3 &mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix3fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
 }
 // ------------------------------------------------------------------------
-void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
+void Shader::setMat4(const char* name, const glm::mat4 &mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, &mat[0][0]);
 }
 
 // utility function for checking shader compilation/linking errors.
@@ -0,0 +1,262 @@
+#version 330 core
+
+// Deferred lighting: fullscreen pass over the G-buffer, point lights come from
+// the same froxel clusters as the forward path
+
+out vec4 FragColor;
+
+// G-buffer
+uniform sampler2D gAlbedoSpec;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+// Uniforms
+uniform vec3 viewPos;
+float shininess; // per fragment, from the G-buffer
+
+// Directional Light
+struct DirLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform DirLight dirLight;
+uniform bool enableDir;
+
+// Point Light
+struct PointLight {
+    vec3 position;
+    float constant;
+    float linear;
+    float quadratic;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+// Clustered point lights: 4 texels per light (position+radius, ambient+constant,
+// diffuse+linear, specular+quadratic), per cluster [offset, count] into lightIndices
+uniform samplerBuffer lightData;
+uniform usamplerBuffer clusterRanges;
+uniform usamplerBuffer lightIndices;
+uniform ivec3 clusterGrid;
+uniform vec2 screenSize;
+uniform float zNear;
+uniform float zFar;
+
+// Cascaded shadow maps of the directional light (static casters cached, dynamic per frame)
+#define CASCADES 4
+uniform sampler2DArrayShadow staticShadowMap;
+uniform sampler2DArrayShadow dynamicShadowMap;
+uniform mat4 staticLightSpace[CASCADES];
+uniform mat4 dynamicLightSpace[CASCADES];
+uniform float cascadeSplits[CASCADES];
+uniform bool enableDynamicShadows;
+
+// Spotlight
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+    float constant;
+    float linear;
+    float quadratic;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform SpotLight spotLight;
+uniform bool enableSpot;
+
+// Function Prototypes
+int clusterIndex(float fragDepth);
+PointLight fetchPointLight(int index);
+float linearDepth(float fragDepth);
+float DirShadow(vec3 fragPos, vec3 normal, float viewDepth);
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseTex, vec3 specularTex, float shadow);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseTex, vec3 specularTex);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseTex, vec3 specularTex);
+
+// [-1,1]^2 -> unit vector (octahedral mapping)
+vec3 octahedronDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main()
+{
+    // the G-buffer has the scene target's pixel grid, only the viewport part is drawn
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec2 screenUV = gl_FragCoord.xy / screenSize;
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    // keep the scene depth for the forward passes drawn afterwards (skybox, impostors)
+    gl_FragDepth = depth;
+    if (depth == 1.0) discard;
+
+    // world position from depth
+    vec4 clip = vec4(vec3(screenUV, depth) * 2.0 - 1.0, 1.0);
+    vec4 world = inverseViewProjection * clip;
+    vec3 FragPos = world.xyz / world.w;
+
+    vec4 albedoSpec = texelFetch(gAlbedoSpec, pixel, 0);
+    vec3 diffuseTex = albedoSpec.rgb;
+    vec3 specularTex = vec3(albedoSpec.a);
+    vec3 normalShininess = texelFetch(gNormal, pixel, 0).xyz;
+    vec3 norm = octahedronDecode(normalShininess.xy);
+    shininess = normalShininess.z;
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    vec3 result = vec3(0.0);
+
+    // Directional light
+    if (enableDir) result += CalcDirLight(dirLight, norm, viewDir, diffuseTex, specularTex, DirShadow(FragPos, norm, linearDepth(depth)));
+
+    // Point lights of this pixel's cluster
+    uvec2 range = texelFetch(clusterRanges, clusterIndex(depth)).xy;
+    for (uint i = 0u; i < range.y; i++)
+        result += CalcPointLight(fetchPointLight(int(texelFetch(lightIndices, int(range.x + i)).r)), norm, FragPos, viewDir, diffuseTex, specularTex);
+
+    // Spotlight
+    if (enableSpot) result += CalcSpotLight(spotLight, norm, FragPos, viewDir, diffuseTex, specularTex);
+
+    FragColor = vec4(result, 1.0);
+}
+
+// Cluster of the current pixel: screen tile + exponential depth slice
+int clusterIndex(float fragDepth)
+{
+    float depth = linearDepth(fragDepth);
+    int z = int(floor(log(depth / zNear) / log(zFar / zNear) * float(clusterGrid.z)));
+    ivec2 tile = ivec2(gl_FragCoord.xy / screenSize * vec2(clusterGrid.xy));
+    ivec3 cluster = clamp(ivec3(tile, z), ivec3(0), clusterGrid - 1);
+    return (cluster.z * clusterGrid.y + cluster.y) * clusterGrid.x + cluster.x;
+}
+
+PointLight fetchPointLight(int index)
+{
+    vec4 t0 = texelFetch(lightData, index * 4);
+    vec4 t1 = texelFetch(lightData, index * 4 + 1);
+    vec4 t2 = texelFetch(lightData, index * 4 + 2);
+    vec4 t3 = texelFetch(lightData, index * 4 + 3);
+    PointLight light;
+    light.position = t0.xyz;
+    light.ambient = t1.xyz;   light.constant = t1.w;
+    light.diffuse = t2.xyz;   light.linear = t2.w;
+    light.specular = t3.xyz;  light.quadratic = t3.w;
+    return light;
+}
+
+// View space distance of a depth buffer value
+float linearDepth(float fragDepth)
+{
+    float ndcDepth = fragDepth * 2.0 - 1.0;
+    return 2.0 * zNear * zFar / (zFar + zNear - ndcDepth * (zFar - zNear));
+}
+
+// 3x3 PCF in one cascade layer
+float SampleShadow(sampler2DArrayShadow shadowMap, vec4 lightSpacePos, int cascade)
+{
+    vec3 p = lightSpacePos.xyz / lightSpacePos.w * 0.5 + 0.5;
+    if (p.z > 1.0) return 1.0;
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float visibility = 0.0;
+    for (int x = -1; x <= 1; x++)
+        for (int y = -1; y <= 1; y++)
+            visibility += texture(shadowMap, vec4(p.xy + vec2(x, y) * texel, float(cascade), p.z));
+    return visibility / 9.0;
+}
+
+// Directional light visibility: static and dynamic casters combined
+float DirShadow(vec3 fragPos, vec3 normal, float viewDepth)
+{
+    if (viewDepth >= cascadeSplits[CASCADES - 1]) return 1.0;
+    int cascade = 0;
+    while (viewDepth >= cascadeSplits[cascade]) cascade++;
+    // normal offset grows with the cascade's texel size
+    vec4 biased = vec4(fragPos + normal * 0.02 * float(cascade + 1), 1.0);
+    float visibility = SampleShadow(staticShadowMap, staticLightSpace[cascade] * biased, cascade);
+    if (enableDynamicShadows)
+        visibility = min(visibility, SampleShadow(dynamicShadowMap, dynamicLightSpace[cascade] * biased, cascade));
+    return visibility;
+}
+
+// Calculate directional light
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseTex, vec3 specularTex, float shadow)
+{
+    vec3 lightDir = normalize(-light.direction);
+
+    // Diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // Specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+
+    // Combine results
+    vec3 ambient = light.ambient * diffuseTex;
+    vec3 diffuse = light.diffuse * diff * diffuseTex;
+    vec3 specular = light.specular * spec * specularTex;
+
+    return ambient + (diffuse + specular) * shadow;
+}
+
+// Calculate point light
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseTex, vec3 specularTex)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+
+    // Diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // Specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+
+    // Attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    // Combine results
+    vec3 ambient = light.ambient * diffuseTex;
+    vec3 diffuse = light.diffuse * diff * diffuseTex;
+    vec3 specular = light.specular * spec * specularTex;
+
+    // Apply attenuation
+    return (ambient + diffuse + specular) * attenuation;
+}
+
+// Calculate spotlight
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseTex, vec3 specularTex)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+
+    // Diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // Specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+
+    // Attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    // Spotlight intensity
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+    // Combine results
+    vec3 ambient = light.ambient * diffuseTex;
+    vec3 diffuse = light.diffuse * diff * diffuseTex;
+    vec3 specular = light.specular * spec * specularTex;
+
+    // Apply attenuation and spotlight intensity
+    return (ambient + diffuse + specular) * attenuation * intensity;
+}
@@ -0,0 +1,52 @@
+#version 330 core
+
+// FXAA (after Timothy Lottes' original): finds the edge direction from the luma
+// of the four diagonal neighbours and blurs along it. The wider four tap blend is
+// kept unless it leaves the local luma range, then the narrow two tap one is used.
+
+out vec4 FragColor;
+
+uniform sampler2D scene;
+// far corner of the rendered part of the target
+uniform vec2 uvScale;
+// 1 / target size
+uniform vec2 texelSize;
+
+const float SPAN_MAX = 8.0;
+const float REDUCE_MUL = 1.0 / 8.0;
+const float REDUCE_MIN = 1.0 / 128.0;
+
+vec3 tap(vec2 uv)
+{
+    // the taps stay inside the rendered part
+    return texture(scene, clamp(uv, 0.5 * texelSize, uvScale - 0.5 * texelSize)).rgb;
+}
+
+float luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy * texelSize;
+    vec3 center = tap(uv);
+    float lumaNW = luma(tap(uv + vec2(-1.0, -1.0) * texelSize));
+    float lumaNE = luma(tap(uv + vec2(1.0, -1.0) * texelSize));
+    float lumaSW = luma(tap(uv + vec2(-1.0, 1.0) * texelSize));
+    float lumaSE = luma(tap(uv + vec2(1.0, 1.0) * texelSize));
+    float lumaM = luma(center);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    // across the luma gradient, along the edge
+    vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * REDUCE_MUL, REDUCE_MIN);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-SPAN_MAX), vec2(SPAN_MAX)) * texelSize;
+
+    vec3 rgbA = 0.5 * (tap(uv + dir * (1.0 / 3.0 - 0.5)) + tap(uv + dir * (2.0 / 3.0 - 0.5)));
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (tap(uv - dir * 0.5) + tap(uv + dir * 0.5));
+    float lumaB = luma(rgbB);
+    FragColor = vec4(lumaB < lumaMin || lumaB > lumaMax ? rgbA : rgbB, 1.0);
+}
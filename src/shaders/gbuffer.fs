@@ -0,0 +1,75 @@
+#version 330 core
+// pipelines (see AlphaMode): default = opaque, ALPHA_TEST = cutout
+
+// Inputs from Vertex Shader (mainShader.vs)
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+in float Fade;
+flat in ivec4 TextureSlots;
+flat in float Shininess;
+
+// G-buffer
+layout (location = 0) out vec4 AlbedoSpec;
+layout (location = 1) out vec3 NormalShininess; // octahedral normal, specular exponent
+
+// Material Properties
+uniform sampler2D texture_diffuse1;
+uniform sampler2D texture_specular1;
+// texture arrays of the model materials (slot N samples textureArray N-1)
+uniform sampler2DArray textureArray0;
+uniform sampler2DArray textureArray1;
+uniform sampler2DArray textureArray2;
+uniform sampler2DArray textureArray3;
+uniform float alpha;
+
+// Interleaved gradient noise in [0,1)
+float dither()
+{
+    return fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+}
+
+// unit vector -> [-1,1]^2 (octahedral mapping)
+vec2 octahedronEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0) e = (1.0 - abs(e.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+    return e;
+}
+
+// slot 0: texture bound to the unit, 1..4: array layer
+// (the slots are constant per draw, so the branches are uniform)
+vec4 sampleArray(int slot, int layer, vec2 uv)
+{
+    vec3 coord = vec3(uv, float(layer));
+    if (slot == 1) return texture(textureArray0, coord);
+    if (slot == 2) return texture(textureArray1, coord);
+    if (slot == 3) return texture(textureArray2, coord);
+    return texture(textureArray3, coord);
+}
+
+vec4 materialDiffuse(vec2 uv)
+{
+    return TextureSlots.x == 0 ? texture(texture_diffuse1, uv) : sampleArray(TextureSlots.x, TextureSlots.y, uv);
+}
+
+vec4 materialSpecular(vec2 uv)
+{
+    return TextureSlots.z == 0 ? texture(texture_specular1, uv) : sampleArray(TextureSlots.z, TextureSlots.w, uv);
+}
+
+void main()
+{
+    vec4 diffuseTex = materialDiffuse(TexCoords);
+    vec4 specularTex = materialSpecular(TexCoords);
+
+#ifdef ALPHA_TEST
+    // same cutout and LOD cross-fade as the forward shader
+    if ((diffuseTex.a + specularTex.a) * alpha < 0.1f) discard;
+    if (Fade > dither()) discard;
+#endif
+
+    AlbedoSpec = vec4(diffuseTex.rgb, dot(specularTex.rgb, vec3(0.299, 0.587, 0.114)));
+    NormalShininess = vec3(octahedronEncode(normalize(Normal)), Shininess);
+}
@@ -0,0 +1,76 @@
+#version 330 core
+
+in vec2 QuadUV;
+in vec3 WorldPos;
+in float Fade;
+flat in vec2 GridPos;
+flat in mat3 NormalMatrix;
+flat in float WorldRadius;
+
+out vec4 FragColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+
+uniform sampler2D colorAtlas;
+uniform sampler2D normalDepthAtlas;
+uniform int framesPerSide;
+
+struct DirLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+};
+uniform DirLight dirLight;
+uniform bool enableDir;
+
+// interleaved gradient noise, used to dither the LOD cross-fade
+float dither()
+{
+    return fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+}
+
+vec2 frameUV(vec2 frame)
+{
+    return (frame + QuadUV) / float(framesPerSide);
+}
+
+void main()
+{
+    if (Fade < dither()) discard;
+
+    // blend the four baked views around the current view direction
+    vec2 cell = clamp(floor(GridPos), vec2(0.0), vec2(float(framesPerSide - 2)));
+    vec2 f = clamp(GridPos - cell, 0.0, 1.0);
+    vec4 c00 = texture(colorAtlas, frameUV(cell));
+    vec4 c10 = texture(colorAtlas, frameUV(cell + vec2(1.0, 0.0)));
+    vec4 c01 = texture(colorAtlas, frameUV(cell + vec2(0.0, 1.0)));
+    vec4 c11 = texture(colorAtlas, frameUV(cell + vec2(1.0, 1.0)));
+    vec4 color = mix(mix(c00, c10, f.x), mix(c01, c11, f.x), f.y);
+    if (color.a < 0.5) discard;
+
+    vec4 n00 = texture(normalDepthAtlas, frameUV(cell));
+    vec4 n10 = texture(normalDepthAtlas, frameUV(cell + vec2(1.0, 0.0)));
+    vec4 n01 = texture(normalDepthAtlas, frameUV(cell + vec2(0.0, 1.0)));
+    vec4 n11 = texture(normalDepthAtlas, frameUV(cell + vec2(1.0, 1.0)));
+    vec4 normalDepth = mix(mix(n00, n10, f.x), mix(n01, n11, f.x), f.y);
+
+    vec3 diffuseTex = color.rgb / color.a;
+    vec3 norm = normalize(NormalMatrix * normalDepth.xyz);
+
+    vec3 result = vec3(0.0);
+    if (enableDir) {
+        float diff = max(dot(norm, normalize(-dirLight.direction)), 0.0);
+        result += (dirLight.ambient + dirLight.diffuse * diff) * diffuseTex;
+    }
+    else result = diffuseTex * 0.2;
+
+    // move the quad fragment to the baked surface so impostors intersect correctly
+    vec3 toCamera = normalize(viewPos - WorldPos);
+    vec3 surface = WorldPos + toCamera * (0.5 - normalDepth.w) * 2.0 * WorldRadius;
+    vec4 clip = projection * view * vec4(surface, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+    FragColor = vec4(result, 1.0);
+}
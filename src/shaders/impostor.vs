@@ -0,0 +1,48 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+layout (location = 3) in mat4 aInstanceModel;
+
+out vec2 QuadUV;
+out vec3 WorldPos;
+out float Fade;
+flat out vec2 GridPos;
+flat out mat3 NormalMatrix;
+flat out float WorldRadius;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+
+uniform vec3 impostorCenter;
+uniform float impostorRadius;
+uniform int framesPerSide;
+uniform vec2 lodFade; // distance where the cross-fade from the mesh starts / ends
+
+// direction on the unit sphere -> [0,1]^2 octahedral atlas position (+Y up)
+vec2 octahedronEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 uv = n.xz;
+    if (n.y < 0.0) uv = (1.0 - abs(uv.yx)) * vec2(uv.x >= 0.0 ? 1.0 : -1.0, uv.y >= 0.0 ? 1.0 : -1.0);
+    return uv * 0.5 + 0.5;
+}
+
+void main(){
+    vec3 worldCenter = vec3(aInstanceModel * vec4(impostorCenter, 1.0));
+    WorldRadius = impostorRadius * length(vec3(aInstanceModel[0]));
+
+    // camera facing quad around the bounding sphere
+    vec3 cameraRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
+    WorldPos = worldCenter + (cameraRight * aCorner.x + cameraUp * aCorner.y) * WorldRadius;
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+
+    // the view direction in model space picks the baked frames
+    mat3 rotation = mat3(aInstanceModel);
+    vec3 toCamera = normalize(inverse(rotation) * (viewPos - worldCenter));
+    GridPos = octahedronEncode(toCamera) * float(framesPerSide - 1);
+    NormalMatrix = rotation;
+
+    QuadUV = aCorner * 0.5 + 0.5;
+    Fade = lodFade.y > lodFade.x ? smoothstep(lodFade.x, lodFade.y, distance(viewPos, vec3(aInstanceModel[3]))) : 1.0;
+}
@@ -0,0 +1,41 @@
+#version 330 core
+
+in vec3 Normal;
+in vec2 TexCoords;
+flat in ivec4 TextureSlots;
+
+layout (location = 0) out vec4 Color;
+layout (location = 1) out vec4 NormalDepth;
+
+uniform sampler2D texture_diffuse1;
+// texture arrays of the model materials (slot N samples textureArray N-1)
+uniform sampler2DArray textureArray0;
+uniform sampler2DArray textureArray1;
+uniform sampler2DArray textureArray2;
+uniform sampler2DArray textureArray3;
+
+// slot 0: texture bound to the unit, 1..4: array layer
+// (the slots are constant per draw, so the branches are uniform)
+vec4 sampleArray(int slot, int layer, vec2 uv)
+{
+    vec3 coord = vec3(uv, float(layer));
+    if (slot == 1) return texture(textureArray0, coord);
+    if (slot == 2) return texture(textureArray1, coord);
+    if (slot == 3) return texture(textureArray2, coord);
+    return texture(textureArray3, coord);
+}
+
+vec4 materialDiffuse(vec2 uv)
+{
+    return TextureSlots.x == 0 ? texture(texture_diffuse1, uv) : sampleArray(TextureSlots.x, TextureSlots.y, uv);
+}
+
+void main()
+{
+    vec4 diffuseTex = materialDiffuse(TexCoords);
+    if (diffuseTex.a < 0.1f) discard;
+
+    // alpha marks covered texels, depth is linear (orthographic bake)
+    Color = vec4(diffuseTex.rgb, 1.0);
+    NormalDepth = vec4(normalize(Normal), gl_FragCoord.z);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 7) in int aMaterial; // constant per mesh, index in the material table
+
+out vec3 Normal;
+out vec2 TexCoords;
+flat out ivec4 TextureSlots;
+
+uniform mat4 view;
+uniform mat4 projection;
+// material table, 2 texels per material: texture slots, (shininess, alpha mode, tiling)
+uniform usamplerBuffer materials;
+
+void main(){
+    gl_Position = projection * view * vec4(aPos, 1.0);
+    Normal = aNormal;
+    TexCoords = aTexCoords;
+    TextureSlots = ivec4(texelFetch(materials, aMaterial * 2));
+}
@@ -1,12 +1,22 @@
 #version 330 core
+// pipelines (see AlphaMode): default = opaque, ALPHA_TEST = cutout, ALPHA_BLEND = translucent
 
 // Inputs from Vertex Shader
 in vec3 Normal;
 in vec3 FragPos;
 in vec2 TexCoords;
+in float Fade;
+flat in ivec4 TextureSlots;
+flat in float Shininess;
 
 // Outputs
+#ifdef ALPHA_BLEND
+// weighted blended OIT targets (see WeightedOIT)
+layout (location = 0) out vec4 Accum;
+layout (location = 1) out float Revealage;
+#else
 out vec4 FragColor;
+#endif
 
 // Uniforms
 uniform vec3 viewPos;
@@ -14,7 +24,11 @@ uniform vec3 viewPos;
 // Material Properties
 uniform sampler2D texture_diffuse1;
 uniform sampler2D texture_specular1;
-uniform float shininess;
+// texture arrays of the model materials (slot N samples textureArray N-1)
+uniform sampler2DArray textureArray0;
+uniform sampler2DArray textureArray1;
+uniform sampler2DArray textureArray2;
+uniform sampler2DArray textureArray3;
 uniform float alpha; // Alpha value to control transparency
 
 // Directional Light
@@ -37,9 +51,24 @@ struct PointLight {
     vec3 diffuse;
     vec3 specular;
 };
-#define NR_POINT_LIGHTS 6
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform int numOfPoints;
+// Clustered point lights: 4 texels per light (position+radius, ambient+constant,
+// diffuse+linear, specular+quadratic), per cluster [offset, count] into lightIndices
+uniform samplerBuffer lightData;
+uniform usamplerBuffer clusterRanges;
+uniform usamplerBuffer lightIndices;
+uniform ivec3 clusterGrid;
+uniform vec2 screenSize;
+uniform float zNear;
+uniform float zFar;
+
+// Cascaded shadow maps of the directional light (static casters cached, dynamic per frame)
+#define CASCADES 4
+uniform sampler2DArrayShadow staticShadowMap;
+uniform sampler2DArrayShadow dynamicShadowMap;
+uniform mat4 staticLightSpace[CASCADES];
+uniform mat4 dynamicLightSpace[CASCADES];
+uniform float cascadeSplits[CASCADES];
+uniform bool enableDynamicShadows;
 
 // Spotlight
 struct SpotLight {
@@ -58,10 +87,36 @@ uniform SpotLight spotLight;
 uniform bool enableSpot;
 
 // Function Prototypes
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseTex, vec3 specularTex);
+float dither();
+int clusterIndex();
+PointLight fetchPointLight(int index);
+float linearDepth(float fragDepth);
+float DirShadow(vec3 fragPos, vec3 normal, float viewDepth);
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseTex, vec3 specularTex, float shadow);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseTex, vec3 specularTex);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseTex, vec3 specularTex);
 
+// slot 0: texture bound to the unit, 1..4: array layer
+// (the slots are constant per draw, so the branches are uniform)
+vec4 sampleArray(int slot, int layer, vec2 uv)
+{
+    vec3 coord = vec3(uv, float(layer));
+    if (slot == 1) return texture(textureArray0, coord);
+    if (slot == 2) return texture(textureArray1, coord);
+    if (slot == 3) return texture(textureArray2, coord);
+    return texture(textureArray3, coord);
+}
+
+vec4 materialDiffuse(vec2 uv)
+{
+    return TextureSlots.x == 0 ? texture(texture_diffuse1, uv) : sampleArray(TextureSlots.x, TextureSlots.y, uv);
+}
+
+vec4 materialSpecular(vec2 uv)
+{
+    return TextureSlots.z == 0 ? texture(texture_specular1, uv) : sampleArray(TextureSlots.z, TextureSlots.w, uv);
+}
+
 void main()
 {
     // Normalize inputs
@@ -69,11 +124,13 @@ void main()
     vec3 viewDir = normalize(viewPos - FragPos);
 
     // Fetch textures once
-    vec3 diffuseTex = vec3(texture(texture_diffuse1, TexCoords));
-    vec3 specularTex = vec3(texture(texture_specular1, TexCoords));
+    vec4 diffuseSample = materialDiffuse(TexCoords);
+    vec4 specularSample = materialSpecular(TexCoords);
+    vec3 diffuseTex = diffuseSample.rgb;
+    vec3 specularTex = specularSample.rgb;
 
     //Transparency value:
-    float alphaValue = (texture(texture_diffuse1, TexCoords).a + texture(texture_specular1, TexCoords).a) * alpha;
+    float alphaValue = (diffuseSample.a + specularSample.a) * alpha;
 
     //Dynamic Alpha based on Distance:
     // float maxDistance = 1000.0f;
@@ -83,28 +140,106 @@ void main()
     // //apply changes:
     // alphaValue*=dynAlpha;
 
+#ifdef ALPHA_TEST
     // Skip processing if alpha is low (transparency)
     if (alphaValue < 0.1f) discard;
 
+    // LOD cross-fade to the impostor (dithered)
+    if (Fade > dither()) discard;
+#endif
+
     // Initialize result color
     vec3 result = vec3(0.0);
 
     // Directional light
-    if (enableDir) result += CalcDirLight(dirLight, norm, viewDir, diffuseTex, specularTex);
+    if (enableDir) result += CalcDirLight(dirLight, norm, viewDir, diffuseTex, specularTex, DirShadow(FragPos, norm, linearDepth(gl_FragCoord.z)));
 
-    // Point lights
-    for (int i = 0; i < numOfPoints; i++) 
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir, diffuseTex, specularTex);
+    // Point lights of this fragment's cluster
+    uvec2 range = texelFetch(clusterRanges, clusterIndex()).xy;
+    for (uint i = 0u; i < range.y; i++)
+        result += CalcPointLight(fetchPointLight(int(texelFetch(lightIndices, int(range.x + i)).r)), norm, FragPos, viewDir, diffuseTex, specularTex);
 
     // Spotlight
     if (enableSpot) result += CalcSpotLight(spotLight, norm, FragPos, viewDir, diffuseTex, specularTex);
 
     // Output the final color
-    FragColor = vec4(result, alphaValue);
+#ifdef ALPHA_BLEND
+    float coverage = clamp(alphaValue * (1.0 - Fade), 0.0, 0.999);
+    // nearer surfaces get more weight since the layers are not sorted
+    float weight = clamp(0.03 / (1e-5 + pow(linearDepth(gl_FragCoord.z) / 200.0, 4.0)), 1e-2, 3e3);
+    Accum = vec4(result * coverage, coverage) * weight;
+    Revealage = -log(1.0 - coverage);
+#else
+    FragColor = vec4(result, 1.0);
+#endif
+}
+
+// Interleaved gradient noise in [0,1)
+float dither()
+{
+    return fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+}
+
+// Cluster of the current fragment: screen tile + exponential depth slice
+int clusterIndex()
+{
+    float depth = linearDepth(gl_FragCoord.z);
+    int z = int(floor(log(depth / zNear) / log(zFar / zNear) * float(clusterGrid.z)));
+    ivec2 tile = ivec2(gl_FragCoord.xy / screenSize * vec2(clusterGrid.xy));
+    ivec3 cluster = clamp(ivec3(tile, z), ivec3(0), clusterGrid - 1);
+    return (cluster.z * clusterGrid.y + cluster.y) * clusterGrid.x + cluster.x;
+}
+
+PointLight fetchPointLight(int index)
+{
+    vec4 t0 = texelFetch(lightData, index * 4);
+    vec4 t1 = texelFetch(lightData, index * 4 + 1);
+    vec4 t2 = texelFetch(lightData, index * 4 + 2);
+    vec4 t3 = texelFetch(lightData, index * 4 + 3);
+    PointLight light;
+    light.position = t0.xyz;
+    light.ambient = t1.xyz;   light.constant = t1.w;
+    light.diffuse = t2.xyz;   light.linear = t2.w;
+    light.specular = t3.xyz;  light.quadratic = t3.w;
+    return light;
+}
+
+// View space distance of a depth buffer value
+float linearDepth(float fragDepth)
+{
+    float ndcDepth = fragDepth * 2.0 - 1.0;
+    return 2.0 * zNear * zFar / (zFar + zNear - ndcDepth * (zFar - zNear));
+}
+
+// 3x3 PCF in one cascade layer
+float SampleShadow(sampler2DArrayShadow shadowMap, vec4 lightSpacePos, int cascade)
+{
+    vec3 p = lightSpacePos.xyz / lightSpacePos.w * 0.5 + 0.5;
+    if (p.z > 1.0) return 1.0;
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float visibility = 0.0;
+    for (int x = -1; x <= 1; x++)
+        for (int y = -1; y <= 1; y++)
+            visibility += texture(shadowMap, vec4(p.xy + vec2(x, y) * texel, float(cascade), p.z));
+    return visibility / 9.0;
+}
+
+// Directional light visibility: static and dynamic casters combined
+float DirShadow(vec3 fragPos, vec3 normal, float viewDepth)
+{
+    if (viewDepth >= cascadeSplits[CASCADES - 1]) return 1.0;
+    int cascade = 0;
+    while (viewDepth >= cascadeSplits[cascade]) cascade++;
+    // normal offset grows with the cascade's texel size
+    vec4 biased = vec4(fragPos + normal * 0.02 * float(cascade + 1), 1.0);
+    float visibility = SampleShadow(staticShadowMap, staticLightSpace[cascade] * biased, cascade);
+    if (enableDynamicShadows)
+        visibility = min(visibility, SampleShadow(dynamicShadowMap, dynamicLightSpace[cascade] * biased, cascade));
+    return visibility;
 }
 
 // Calculate directional light
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseTex, vec3 specularTex)
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseTex, vec3 specularTex, float shadow)
 {
     vec3 lightDir = normalize(-light.direction);
 
@@ -113,14 +248,14 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseTex, ve
 
     // Specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), Shininess);
 
     // Combine results
     vec3 ambient = light.ambient * diffuseTex;
     vec3 diffuse = light.diffuse * diff * diffuseTex;
     vec3 specular = light.specular * spec * specularTex;
 
-    return ambient + diffuse + specular;
+    return ambient + (diffuse + specular) * shadow;
 }
 
 // Calculate point light
@@ -133,7 +268,7 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, v
 
     // Specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), Shininess);
 
     // Attenuation
     float distance = length(light.position - fragPos);
@@ -158,7 +293,7 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec
 
     // Specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), Shininess);
 
     // Attenuation
     float distance = length(light.position - fragPos);
@@ -3,19 +3,32 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 layout (location = 3) in mat4 aInstanceModel;
+layout (location = 7) in int aMaterial; // constant per mesh, index in the material table
 
 out vec3 Normal;
 out vec3 FragPos;
 out vec2 TexCoords;
+out float Fade;
+flat out ivec4 TextureSlots;
+flat out float Shininess;
 
 uniform mat4 view;
 uniform mat4 projection;
 
-uniform float textureCnt;
+// material table, 2 texels per material: texture slots, (shininess, alpha mode, tiling)
+uniform usamplerBuffer materials;
+
+uniform vec3 viewPos;
+uniform vec2 lodFade; // distance where the cross-fade to an impostor starts / ends, (0,0) = off
 
 void main(){
     gl_Position = projection * view * aInstanceModel * vec4(aPos, 1.0);
     Normal = mat3(transpose(inverse(aInstanceModel))) * aNormal; 
     FragPos = vec3(aInstanceModel * vec4(aPos, 1.0));
-    TexCoords = aTexCoords*textureCnt;
+    int material = aMaterial * 2;
+    uvec4 params = texelFetch(materials, material + 1);
+    TexCoords = aTexCoords * uintBitsToFloat(params.z);
+    TextureSlots = ivec4(texelFetch(materials, material));
+    Shininess = uintBitsToFloat(params.x);
+    Fade = lodFade.y > lodFade.x ? smoothstep(lodFade.x, lodFade.y, distance(viewPos, vec3(aInstanceModel[3]))) : 0.0;
 }
\ No newline at end of file
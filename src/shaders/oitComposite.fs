@@ -0,0 +1,23 @@
+#version 330 core
+
+out vec4 FragColor;
+
+uniform sampler2D accum;
+uniform sampler2D revealage;
+
+void main()
+{
+    // same pixel grid as the scene target (which may be drawn at a lower resolution)
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float logRevealage = texelFetch(revealage, pixel, 0).r;
+    if (logRevealage <= 0.0) discard; // nothing translucent here
+
+    vec4 sum = texelFetch(accum, pixel, 0);
+    // 16 bit floats overflow to inf under many bright layers
+    if (isinf(max(max(abs(sum.r), abs(sum.g)), max(abs(sum.b), abs(sum.a))))) sum.rgb = vec3(sum.a);
+    vec3 average = sum.rgb / max(sum.a, 1e-5);
+    float coverage = 1.0 - exp(-logRevealage);
+
+    // blended with GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA over the opaque scene
+    FragColor = vec4(average, coverage);
+}
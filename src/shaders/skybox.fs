@@ -1,12 +1,25 @@
 #version 330 core
 out vec4 FragColor;
 
-in vec3 TexCoords;
+in vec2 NDC;
 
-uniform samplerCube skybox;
+uniform samplerCube dayMap;
+uniform samplerCube nightMap;
+// 0 = day, 1 = night, anything between cross-fades the two maps
+uniform float night;
+// inverse of projection * rotation-only view
+uniform mat4 inverseViewProjection;
 
 void main()
-{    
-    FragColor = texture(skybox, TexCoords);
+{
+    vec4 farPoint = inverseViewProjection * vec4(NDC, 1.0, 1.0);
+    vec3 direction = farPoint.xyz / farPoint.w;
 
-}
\ No newline at end of file
+    // the uniform is the same for every fragment, so the branches don't diverge
+    if (night <= 0.0)
+        FragColor = texture(dayMap, direction);
+    else if (night >= 1.0)
+        FragColor = texture(nightMap, direction);
+    else
+        FragColor = mix(texture(dayMap, direction), texture(nightMap, direction), night);
+}
@@ -1,14 +1,11 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
 
-out vec3 TexCoords;
-
-uniform mat4 projection;
-uniform mat4 view;
+out vec2 NDC;
 
+// fullscreen triangle on the far plane (z = w), so the sky only fills what
+// the scene left at the cleared depth
 void main()
 {
-    TexCoords = aPos;
-    vec4 pos = projection * view * vec4(aPos, 1.0);
-    gl_Position = pos.xyww;
-}
\ No newline at end of file
+    NDC = vec2(float((gl_VertexID & 1) << 2) - 1.0, float((gl_VertexID & 2) << 1) - 1.0);
+    gl_Position = vec4(NDC, 1.0, 1.0);
+}
@@ -0,0 +1,63 @@
+#version 330 core
+
+// Temporal AA resolve: this frame blended into the reprojected history. The
+// history is clipped (in YCoCg) to a box around the mean of the 3x3 neighbourhood
+// of this frame, so what was disoccluded or changed doesn't ghost.
+
+out vec4 FragColor;
+
+uniform sampler2D scene;
+uniform sampler2D velocity;
+uniform sampler2D history;
+// 1 / target size
+uniform vec2 texelSize;
+// far corner of the rendered part, this and the last frame (the scale may change)
+uniform vec2 uvScale;
+uniform vec2 previousUvScale;
+// false on the first frame
+uniform bool historyValid;
+// share of the history in the result
+uniform float feedback;
+
+vec3 toYCoCg(vec3 c)
+{
+    return vec3(0.25 * c.r + 0.5 * c.g + 0.25 * c.b, 0.5 * c.r - 0.5 * c.b, -0.25 * c.r + 0.5 * c.g - 0.25 * c.b);
+}
+
+vec3 toRGB(vec3 c)
+{
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec3 current = texelFetch(scene, pixel, 0).rgb;
+    vec2 uv = gl_FragCoord.xy * texelSize / uvScale;
+    vec2 previousUV = uv - texelFetch(velocity, pixel, 0).rg;
+    if (!historyValid || any(lessThan(previousUV, vec2(0.0))) || any(greaterThan(previousUV, vec2(1.0)))) {
+        FragColor = vec4(current, 1.0);
+        return;
+    }
+
+    // mean and deviation of the neighbourhood
+    ivec2 last = ivec2(uvScale / texelSize + 0.5) - 1;
+    vec3 sum = vec3(0.0), sumSquares = vec3(0.0);
+    for (int y = -1; y <= 1; y++)
+        for (int x = -1; x <= 1; x++) {
+            vec3 c = toYCoCg(texelFetch(scene, clamp(pixel + ivec2(x, y), ivec2(0), last), 0).rgb);
+            sum += c;
+            sumSquares += c * c;
+        }
+    vec3 mean = sum / 9.0;
+    vec3 extent = sqrt(max(sumSquares / 9.0 - mean * mean, 0.0)) * 1.25 + 1e-4;
+
+    vec2 historyUV = clamp(previousUV * previousUvScale, 0.5 * texelSize, previousUvScale - 0.5 * texelSize);
+    vec3 past = toYCoCg(texture(history, historyUV).rgb);
+    vec3 offset = past - mean;
+    vec3 units = abs(offset / extent);
+    float outside = max(units.x, max(units.y, units.z));
+    if (outside > 1.0) past = mean + offset / outside;
+
+    FragColor = vec4(toRGB(mix(toYCoCg(current), past, feedback)), 1.0);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+
+// Camera motion of every pixel since the last frame: the depth is unprojected with
+// this frame's (jittered) view projection and projected again with the last one's.
+
+out vec2 FragColor;
+
+uniform sampler2D depth;
+uniform mat4 inverseViewProjection;
+uniform mat4 previousViewProjection;
+// size of the rendered part in pixels
+uniform vec2 screenSize;
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / screenSize;
+    float z = texelFetch(depth, ivec2(gl_FragCoord.xy), 0).r;
+    vec4 world = inverseViewProjection * vec4(vec3(uv, z) * 2.0 - 1.0, 1.0);
+    vec4 previous = previousViewProjection * vec4(world.xyz / world.w, 1.0);
+    // where the history has this pixel is uv - velocity
+    FragColor = uv - (previous.xy / previous.w * 0.5 + 0.5);
+}
@@ -0,0 +1,41 @@
+#version 330 core
+
+// Dynamic resolution upscale to the window: bilinear, then a contrast adaptive
+// sharpen (after AMD's CAS) that wins back some of the detail the lower
+// resolution lost. Flat areas get the most, edges with high contrast the least,
+// so they don't ring.
+
+in vec2 TexCoords;
+
+out vec4 FragColor;
+
+uniform sampler2D scene;
+// far corner of the rendered part of the target
+uniform vec2 uvScale;
+// 1 / target size
+uniform vec2 texelSize;
+// 0: plain bilinear, 1: strongest
+uniform float sharpness;
+
+void main()
+{
+    // the taps stay inside the rendered part
+    vec2 low = 0.5 * texelSize, high = uvScale - 0.5 * texelSize;
+    vec2 uv = clamp(TexCoords * uvScale, low, high);
+    vec3 center = texture(scene, uv).rgb;
+    if (sharpness <= 0.0) {
+        FragColor = vec4(center, 1.0);
+        return;
+    }
+    vec3 north = texture(scene, clamp(uv + vec2(0.0, texelSize.y), low, high)).rgb;
+    vec3 south = texture(scene, clamp(uv - vec2(0.0, texelSize.y), low, high)).rgb;
+    vec3 east = texture(scene, clamp(uv + vec2(texelSize.x, 0.0), low, high)).rgb;
+    vec3 west = texture(scene, clamp(uv - vec2(texelSize.x, 0.0), low, high)).rgb;
+
+    vec3 minimum = min(center, min(min(north, south), min(east, west)));
+    vec3 maximum = max(center, max(max(north, south), max(east, west)));
+    vec3 amount = sqrt(clamp(min(minimum, 1.0 - maximum) / max(maximum, vec3(1e-4)), 0.0, 1.0));
+    vec3 weight = -amount * 0.2 * sharpness;
+    vec3 result = (center + (north + south + east + west) * weight) / (1.0 + 4.0 * weight);
+    FragColor = vec4(clamp(result, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,85 @@
+// Contention benchmark of the JobSystem: how many tiny jobs a second get through
+// when they all come in from outside at once, when one worker spawns them (the
+// others steal), and as parallelFor() chunks.
+//
+//   g++ -std=c++17 -O2 -Iincludes tests/JobSystemBenchmark.cpp src/JobSystem.cpp -pthread -o jobSystemBenchmark
+//   jobSystemBenchmark [workers]
+#include "JobSystem.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+static const int JOBS = 200000;
+static const int REPEATS = 5;
+
+// best of REPEATS, in jobs per second
+template<class Body>
+static double measure(Body body)
+{
+	double best = 0.0;
+	for (int r = 0; r < REPEATS; r++) {
+		auto start = std::chrono::steady_clock::now();
+		body();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		best = std::max(best, JOBS / seconds);
+	}
+	return best;
+}
+
+// producers threads hand in JOBS jobs between them
+static double injected(JobSystem& jobs, int producers)
+{
+	return measure([&] {
+		std::atomic<int> ran(0);
+		std::vector<std::thread> threads;
+		for (int p = 0; p < producers; p++)
+			threads.emplace_back([&] {
+				JobCounter counter;
+				for (int i = 0; i < JOBS / producers; i++)
+					jobs.run([&ran] { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+				jobs.wait(counter);
+			});
+		for (std::thread& thread : threads) thread.join();
+	});
+}
+
+// one worker pushes everything on its own deque, the rest steal
+static double spawned(JobSystem& jobs)
+{
+	return measure([&] {
+		std::atomic<int> ran(0);
+		JobCounter spawner, children;
+		jobs.run([&] {
+			for (int i = 0; i < JOBS; i++) jobs.run([&ran] { ran.fetch_add(1, std::memory_order_relaxed); }, &children);
+		}, &spawner, JobPriority::Background);
+		jobs.wait(spawner);
+		jobs.wait(children);
+	});
+}
+
+// JOBS chunks of one item each
+static double chunks(JobSystem& jobs)
+{
+	std::vector<int> items(JOBS);
+	return measure([&] {
+		jobs.parallelFor(items.size(), 1, [&items](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) items[i]++;
+		});
+	});
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int workers = argc > 1 ? (unsigned int)std::atoi(argv[1])
+	                                : std::max(2u, std::thread::hardware_concurrency()) - 1;
+	JobSystem jobs(workers);
+	std::printf("%u workers, %d jobs, best of %d\n", jobs.workerCount(), JOBS, REPEATS);
+	for (int producers : { 1, 2, 4, 8, 16 })
+		std::printf("injected, %2d producers: %8.2f Mjobs/s\n", producers, injected(jobs, producers) / 1e6);
+	std::printf("spawned by one worker:  %8.2f Mjobs/s\n", spawned(jobs) / 1e6);
+	std::printf("parallelFor, grain 1:   %8.2f Mjobs/s\n", chunks(jobs) / 1e6);
+	return 0;
+}
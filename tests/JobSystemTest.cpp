@@ -0,0 +1,250 @@
+// Checks of the JobSystem on its own, without a window or GL context.
+//
+//   g++ -std=c++17 -O2 -Iincludes tests/JobSystemTest.cpp src/JobSystem.cpp -pthread -o jobSystemTest
+//   jobSystemTest
+//
+// Prints every failed check and exits with 1 if there was one. Build it once more
+// with -fsanitize=thread (and -O1 -g) to have the races looked for as well.
+#include "JobSystem.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::cout << "FAILED " << __FILE__ << ":" << __LINE__ << ": " #condition << std::endl; \
+			failures++; \
+		} \
+	} while (0)
+
+static void runAndWait(JobSystem& jobs)
+{
+	const int COUNT = 10000;
+	std::atomic<int> ran(0);
+	JobCounter counter;
+	for (int i = 0; i < COUNT; i++) jobs.run([&ran] { ran.fetch_add(1, std::memory_order_relaxed); }, &counter);
+	jobs.wait(counter);
+	CHECK(counter.done());
+	CHECK(ran.load() == COUNT);
+
+	// Background jobs only run on the workers, wait() still returns
+	JobCounter background;
+	for (int i = 0; i < 100; i++)
+		jobs.run([&ran] { ran.fetch_add(1, std::memory_order_relaxed); }, &background, JobPriority::Background);
+	jobs.wait(background);
+	CHECK(ran.load() == COUNT + 100);
+
+	// nothing to wait for
+	JobCounter empty;
+	jobs.wait(empty);
+	CHECK(empty.done());
+}
+
+static void nestedJobs(JobSystem& jobs)
+{
+	// jobs that queue and wait for jobs of their own, from the workers' deques
+	std::atomic<int> ran(0);
+	JobCounter outer;
+	for (int i = 0; i < 16; i++)
+		jobs.run([&jobs, &ran] {
+			JobCounter inner;
+			for (int j = 0; j < 100; j++) jobs.run([&ran] { ran.fetch_add(1, std::memory_order_relaxed); }, &inner);
+			jobs.wait(inner);
+		}, &outer);
+	jobs.wait(outer);
+	CHECK(ran.load() == 16 * 100);
+}
+
+static void runAfterChain(JobSystem& jobs)
+{
+	// every stage starts once the one before is done
+	const int STAGES = 64;
+	std::vector<std::unique_ptr<JobCounter>> counters;
+	for (int i = 0; i < STAGES; i++) counters.emplace_back(new JobCounter());
+	std::mutex orderMutex;
+	std::vector<int> order;
+	jobs.hold(*counters[0]);
+	for (int i = 1; i < STAGES; i++)
+		jobs.runAfter(*counters[i - 1], [i, &orderMutex, &order] {
+			std::lock_guard<std::mutex> lock(orderMutex);
+			order.push_back(i);
+		}, counters[i].get());
+	// nothing may start while the first stage is held
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	{
+		std::lock_guard<std::mutex> lock(orderMutex);
+		CHECK(order.empty());
+	}
+	jobs.release(*counters[0]);
+	jobs.wait(*counters[STAGES - 1]);
+	CHECK((int)order.size() == STAGES - 1);
+	for (size_t i = 0; i < order.size(); i++) CHECK(order[i] == (int)i + 1);
+
+	// several continuations of one counter, one after a counter that is done already
+	JobCounter first, second;
+	std::atomic<int> ran(0);
+	jobs.run([] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); }, &first);
+	for (int i = 0; i < 10; i++) jobs.runAfter(first, [&ran] { ran.fetch_add(1); }, &second);
+	jobs.wait(second);
+	CHECK(ran.load() == 10);
+	jobs.runAfter(first, [&ran] { ran.fetch_add(1); }, &second);
+	jobs.wait(second);
+	CHECK(ran.load() == 11);
+}
+
+static void holdAndRelease(JobSystem& jobs)
+{
+	// work outside the job system (another thread here) keeps the counter up
+	JobCounter counter;
+	std::atomic<bool> outsideDone(false), continued(false);
+	jobs.hold(counter);
+	jobs.runAfter(counter, [&] { continued = outsideDone.load(); });
+	std::thread outside([&] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		outsideDone = true;
+		jobs.release(counter);
+	});
+	jobs.wait(counter);
+	CHECK(outsideDone.load());
+	outside.join();
+	// the continuation was queued by release(), give it the time to run
+	for (int i = 0; i < 1000 && !continued.load(); i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	CHECK(continued.load());
+
+	// holds nest: the counter drops once the last one is released
+	JobCounter nested;
+	jobs.hold(nested);
+	jobs.hold(nested);
+	jobs.release(nested);
+	CHECK(!nested.done());
+	jobs.release(nested);
+	CHECK(nested.done());
+}
+
+static void manyProducers(JobSystem& jobs)
+{
+	// threads that aren't workers all hand jobs in at once
+	const int PRODUCERS = 8, JOBS = 5000;
+	std::atomic<int> ran(0);
+	std::mutex threadsMutex;
+	std::set<std::thread::id> threads;
+	std::vector<std::thread> producers;
+	for (int p = 0; p < PRODUCERS; p++)
+		producers.emplace_back([&] {
+			JobCounter counter;
+			for (int i = 0; i < JOBS; i++)
+				jobs.run([&] {
+					if (ran.fetch_add(1, std::memory_order_relaxed) % 64 == 0) {
+						std::lock_guard<std::mutex> lock(threadsMutex);
+						threads.insert(std::this_thread::get_id());
+					}
+				}, &counter);
+			jobs.wait(counter);
+		});
+	for (std::thread& producer : producers) producer.join();
+	CHECK(ran.load() == PRODUCERS * JOBS);
+	CHECK(!threads.empty());
+}
+
+static void stealing(JobSystem& jobs)
+{
+	if (jobs.workerCount() < 2) {
+		std::cout << "stealing: skipped, one worker" << std::endl;
+		return;
+	}
+	// one worker queues everything on its own deque; the others can only get at it by stealing
+	const int JOBS = 2000;
+	std::atomic<int> ran(0);
+	std::mutex threadsMutex;
+	std::set<std::thread::id> threads;
+	std::thread::id spawner;
+	JobCounter spawned, children;
+	// Background: wait() won't take it, so it runs on a worker
+	jobs.run([&] {
+		spawner = std::this_thread::get_id();
+		for (int i = 0; i < JOBS; i++)
+			jobs.run([&] {
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+				ran.fetch_add(1, std::memory_order_relaxed);
+				std::lock_guard<std::mutex> lock(threadsMutex);
+				threads.insert(std::this_thread::get_id());
+			}, &children);
+	}, &spawned, JobPriority::Background);
+	jobs.wait(spawned);
+	jobs.wait(children);
+	CHECK(ran.load() == JOBS);
+	threads.erase(spawner);
+	threads.erase(std::this_thread::get_id());
+	CHECK(!threads.empty());
+}
+
+static void parallelFor(JobSystem& jobs)
+{
+	const size_t COUNT = 100003;
+	std::vector<std::atomic<int>> visits(COUNT);
+	for (std::atomic<int>& visit : visits) visit = 0;
+	jobs.parallelFor(COUNT, 1000, [&visits](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) visits[i].fetch_add(1, std::memory_order_relaxed);
+	});
+	bool once = true;
+	for (std::atomic<int>& visit : visits) once = once && visit.load() == 1;
+	CHECK(once);
+
+	// one chunk runs on the calling thread
+	std::thread::id caller;
+	jobs.parallelFor(10, 100, [&caller](size_t, size_t) { caller = std::this_thread::get_id(); });
+	CHECK(caller == std::this_thread::get_id());
+}
+
+static void glJobs(JobSystem& jobs)
+{
+	// this thread stands in for the one with the context
+	jobs.setGLThread();
+	std::atomic<int> woken(0);
+	jobs.setGLWake([&woken] { woken.fetch_add(1); });
+	std::thread::id ranOn;
+	JobCounter counter;
+	// the queuing job counts too, so the counter can't drop before the GL job is in
+	jobs.run([&] { jobs.runOnGLThread([&ranOn] { ranOn = std::this_thread::get_id(); }, &counter); }, &counter);
+	// wait() runs GL jobs on the GL thread
+	jobs.wait(counter);
+	CHECK(ranOn == std::this_thread::get_id());
+	CHECK(woken.load() == 1);
+
+	// without a wait: runGLJobs()
+	bool ran = false;
+	jobs.runOnGLThread([&ran] { ran = true; });
+	CHECK(!ran);
+	jobs.runGLJobs();
+	CHECK(ran);
+	jobs.setGLWake(nullptr);
+}
+
+int main()
+{
+	for (unsigned int threads : { 1u, 4u }) {
+		JobSystem jobs(threads);
+		std::cout << "workers: " << jobs.workerCount() << std::endl;
+		runAndWait(jobs);
+		nestedJobs(jobs);
+		runAfterChain(jobs);
+		holdAndRelease(jobs);
+		manyProducers(jobs);
+		stealing(jobs);
+		parallelFor(jobs);
+		glJobs(jobs);
+	}
+	if (failures) {
+		std::cout << failures << " check(s) failed" << std::endl;
+		return 1;
+	}
+	std::cout << "all passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,114 @@
+// Offline texture cooker: writes a block compressed KTX2 file with its whole mip
+// chain next to every source image (see KTX2Texture::cookedPath). The runtime
+// takes the cooked file when it is fresh and falls back to the source otherwise.
+//
+//   g++ -std=c++17 -O2 -Iincludes -I<glad include> tools/TextureCooker.cpp src/BlockCompression.cpp src/KTX2.cpp src/stb_image.cpp -pthread -o textureCooker
+//   textureCooker [--normal] [--no-flip] [--force] [--threads N] <image or directory>...
+//
+// Opaque images become BC1, images with alpha BC3, --normal images BC5. Images are
+// flipped like the renderer loads them unless --no-flip is given.
+#include "AlphaMode.h"
+#include "BlockCompression.h"
+#include "KTX2.h"
+#include "MipChain.h"
+#include <stb_image.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CookOptions
+{
+    bool normal = false;
+    bool flip = true;
+    bool force = false;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+};
+
+static bool cook(const std::string& path, const CookOptions& options)
+{
+    KTX2Texture existing;
+    if (!options.force && KTX2Texture::findCooked(path, options.flip, existing, true)) {
+        std::cout << "up to date: " << path << std::endl;
+        return true;
+    }
+
+    stbi_set_flip_vertically_on_load(options.flip);
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!pixels) {
+        std::cout << "ERROR::TEXTURE_COOKER::LOAD_FAILED " << path << std::endl;
+        return false;
+    }
+    AlphaMode alphaMode = classifyAlpha(pixels, width, height, 4);
+
+    KTX2Texture texture;
+    texture.width = width;
+    texture.height = height;
+    if (options.normal) texture.vkFormat = KTX2_BC5;
+    else texture.vkFormat = alphaMode == ALPHA_OPAQUE ? KTX2_BC1_RGB : KTX2_BC3;
+    texture.metadata["KTXorientation"] = options.flip ? "ru" : "rd";
+    texture.metadata["KTXwriter"] = "textureCooker";
+    texture.metadata["alphaMode"] = alphaModeName(alphaMode);
+
+    std::vector<unsigned char> current(pixels, pixels + (size_t)width * height * 4), next;
+    stbi_image_free(pixels);
+    int levelWidth = width, levelHeight = height;
+    while (true) {
+        texture.levels.push_back(compressImage(current.data(), levelWidth, levelHeight, texture.vkFormat, options.threads));
+        if (levelWidth == 1 && levelHeight == 1) break;
+        halveImage(current, levelWidth, levelHeight, 4, next);
+        current.swap(next);
+    }
+    texture.levelCount = (int)texture.levels.size();
+
+    std::string output = KTX2Texture::cookedPath(path);
+    if (!texture.write(output)) {
+        std::cout << "ERROR::TEXTURE_COOKER::WRITE_FAILED " << output << std::endl;
+        return false;
+    }
+    std::cout << "cooked: " << output << " (" << width << "x" << height << ", " << texture.levelCount << " levels, "
+              << alphaModeName(alphaMode) << ")" << std::endl;
+    return true;
+}
+
+static bool isImage(const std::filesystem::path& path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
+
+int main(int argc, char** argv)
+{
+    CookOptions options;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--normal") options.normal = true;
+        else if (argument == "--no-flip") options.flip = false;
+        else if (argument == "--force") options.force = true;
+        else if (argument == "--threads" && i + 1 < argc) options.threads = std::max(1, std::atoi(argv[++i]));
+        else inputs.push_back(argument);
+    }
+    if (inputs.empty()) {
+        std::cout << "usage: textureCooker [--normal] [--no-flip] [--force] [--threads N] <image or directory>..." << std::endl;
+        return 1;
+    }
+
+    int failed = 0;
+    for (const std::string& input : inputs) {
+        if (std::filesystem::is_directory(input)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(input))
+                if (entry.is_regular_file() && isImage(entry.path()))
+                    failed += !cook(entry.path().string(), options);
+        } else {
+            failed += !cook(input, options);
+        }
+    }
+    return failed ? 1 : 0;
+}